@@ -12,7 +12,8 @@
  * the page directory.
  */
 .text
-.globl idt,gdt,pg_dir,tmp_floppy_area
+.globl idt,gdt,pg_dir,tmp_floppy_area,empty_zero_page
+.globl x86,x86_model,x86_mask,x86_capability
 pg_dir:					# 页目录将会存放于此
 /*
  * 这里已经处于32位运行模式，因此这里的$0x10并不是把地址0x10装入各个段寄存器，它现在其实
@@ -66,8 +67,62 @@ startup_32:				# 设置各个数据段寄存器
 	orl $2,%eax		# set MP
 	movl %eax,%cr0
 	call check_x87
+	call check_cpu
 	jmp after_page_tables
 
+/*
+ * check_cpu sets x86 to the cpu family: 3 if we can't toggle the AC
+ * flag, 4 if we can but there is no cpuid, else whatever cpuid says.
+ * x86_capability gets the cpuid feature flags (0 without cpuid), and
+ * is used by setup_paging to decide on 4Mb pages. x86_model and x86_mask
+ * (the stepping) are only known with cpuid.
+ */
+check_cpu:
+	movl $3,x86
+	pushfl
+	popl %ecx		# original eflags
+	movl %ecx,%eax
+	xorl $0x40000,%eax	# try to flip AC
+	pushl %eax
+	popfl
+	pushfl
+	popl %eax
+	pushl %ecx
+	popfl
+	xorl %ecx,%eax
+	testl $0x40000,%eax
+	je 1f			# 386
+	movl $4,x86
+	movl %ecx,%eax
+	xorl $0x200000,%eax	# try to flip ID
+	pushl %eax
+	popfl
+	pushfl
+	popl %eax
+	pushl %ecx
+	popfl
+	xorl %ecx,%eax
+	testl $0x200000,%eax
+	je 1f			# 486 without cpuid
+	xorl %eax,%eax
+	cpuid
+	cmpl $1,%eax
+	jb 1f
+	movl $1,%eax
+	cpuid
+	movl %edx,x86_capability
+	movl %eax,%edx
+	andl $0x0f,%edx
+	movl %edx,x86_mask	# stepping
+	movl %eax,%edx
+	shrl $4,%edx
+	andl $0x0f,%edx
+	movl %edx,x86_model
+	shrl $8,%eax
+	andl $0x0f,%eax
+	movl %eax,x86
+1:	ret
+
 /*
  * We depend on ET to be correct. This checks for 287/387.
  */
@@ -155,14 +210,23 @@ pg2:
 .org 0x4000
 pg3:
 
-.org 0x5000		# 定义下面的内存数据块从偏移0x5000处开始
+.org 0x5000
+/*
+ * empty_zero_page is mapped read-only into user space on read faults
+ * of untouched anonymous memory (see mm/memory.c). It must stay all
+ * zeroes, and as it is below LOW_MEM it is never reference-counted.
+ */
+empty_zero_page:
+
+.org 0x6000		# 定义下面的内存数据块从偏移0x6000处开始
 /*
  * tmp_floppy_area is used by the floppy-driver when DMA cannot
- * reach to a buffer-block. It needs to be aligned, so that it isn't
- * on a 64kB border.
+ * reach to a buffer-block, and as its track buffer: it holds one
+ * full cylinder (2 heads of 18 sectors). It needs to be aligned, so
+ * that it isn't on a 64kB border.
  */
 tmp_floppy_area:
-	.fill 1024,1,0	# 共保留1024项，每项1字节，填充数值0
+	.fill 18*2*512,1,0	# 一个柱面(2个磁头各18扇区)，填充数值0
 
 after_page_tables:
 	pushl $0		# These are the parameters to main :-)
@@ -257,13 +321,60 @@ setup_paging:				# 首先对5页内存（1页目录+4页页表）清零
 1:	stosl			/* fill pages backwards - more efficient :-) */
 	subl $0x1000,%eax		# 每填写好一项，物理地址值减0x1000
 	jge 1b
+	cld
+/*
+ * With PSE the 4-16Mb range is mapped with three 4Mb pages instead of
+ * pg1-pg3, and with PGE that mapping is made global so that invalidate()
+ * doesn't throw it out of the TLB. The first 4Mb keep their page table
+ * and are never global: copy_page_tables() copies pg0 into task 1, and
+ * a global entry at TASK_BASE would outlive the cr3 load in switch_to.
+ */
+	xorl %edx,%edx
+	testl $0x2000,x86_capability	/* PGE */
+	je 2f
+	movl $0x100,%edx		/* G */
+	movl $pg1,%edi
+	movl $1024*3,%ecx
+1:	orl %edx,(%edi)
+	addl $4,%edi
+	decl %ecx
+	jne 1b
+2:	testl $0x8,x86_capability	/* PSE */
+	je 3f
+	movl %cr4,%eax
+	orl $0x10,%eax
+	movl %eax,%cr4
+	movl $0x400087,%eax		/* 4Mb + PS + 7 (r/w user,p) */
+	orl %edx,%eax
+	movl $pg_dir+4,%edi
+	movl $3,%ecx
+1:	movl %eax,(%edi)
+	addl $0x400000,%eax
+	addl $4,%edi
+	decl %ecx
+	jne 1b
+3:
 # 设置页目录基址寄存器cr3的值，指向页目录表。cr3中保存的是页目录表的物理地址。
 	xorl %eax,%eax		/* pg_dir is at 0x0000 */
 	movl %eax,%cr3		/* cr3 - page directory start */
 	movl %cr0,%eax
 	orl $0x80000000,%eax	# 添上PG标志
 	movl %eax,%cr0		/* set paging (PG) bit */
-	ret			/* this also flushes prefetch-queue */
+	testl $0x2000,x86_capability	/* PGE only after PG is set */
+	je 1f
+	movl %cr4,%eax
+	orl $0x80,%eax
+	movl %eax,%cr4
+1:	ret			/* this also flushes prefetch-queue */
+
+.align 2
+x86:	.long 0			# cpu family, see check_cpu
+x86_model:
+	.long 0
+x86_mask:
+	.long 0			# stepping
+x86_capability:
+	.long 0			# cpuid feature flags
 
 # 在改变分页处理标志后要求使用转移指令刷新预取指令队列，这里用的是返回指令ret。
 # 该返回指令的另一个作用是将140行压入堆栈中的main程序地址弹出，并跳转到init/main.c程序去运行
@@ -287,11 +398,11 @@ gdt_descr:
 	.align 8
 idt:	.fill 256,8,0		# idt is uninitialized
 
-# 全局表。前4项分别是空项、代码短描述符、数据段描述符、临时描述符，后面还预留了252项的空间，用于
-# 放置所创建任务的局部描述符（LDT）和对应的任务状态段TSS的描述符。
-# （0-nul，1-cs，2-ds，3-syscall，4-TSS0，5-LDT0,6-TSS1,7-LDT1,8-TSS2 etc...）
+# 全局表。前4项分别是空项、代码短描述符、数据段描述符、临时描述符，第4、5项是系统唯一的
+# 任务状态段TSS描述符和局部描述符表LDT描述符（任务切换时改写其基址），其余留作它用。
+# （0-nul，1-cs，2-ds，3-syscall，4-TSS，5-LDT）
 gdt:	.quad 0x0000000000000000	/* NULL descriptor */
 	.quad 0x00c09a0000000fff	/* 16Mb */ # 0x08，内核代码段最大长度16MB
 	.quad 0x00c0920000000fff	/* 16Mb */ # 0x10，内核数据段最大长度16MB
 	.quad 0x0000000000000000	/* TEMPORARY - don't use */
-	.fill 252,8,0			/* space for LDT's and TSS's etc */
+	.fill 252,8,0			/* space for the TSS, the LDT etc */
@@ -40,7 +40,7 @@ extern void invalidate_inodes(int);
 struct buffer_head * start_buffer = (struct buffer_head *) &end;
 struct buffer_head * hash_table[NR_HASH];           // NR_HASH ＝ 307项
 static struct buffer_head * free_list;              // 空闲缓冲块链表头指针
-static struct task_struct * buffer_wait = NULL;     // 等待空闲缓冲块而睡眠的任务队列
+static struct wait_queue * buffer_wait = NULL;     // 等待空闲缓冲块而睡眠的任务队列
 // 下面定义系统缓冲区中含有的缓冲块个数。这里，NR_BUFFERS是一个定义在linux/fs.h中的
 // 宏，其值即使变量名nr_buffers，并且在fs.h文件中声明为全局变量。大写名称通常都是一个
 // 宏名称，Linus这样编写代码是为了利用这个大写名称来隐含地表示nr_buffers是一个在内核
@@ -55,10 +55,13 @@ int NR_BUFFERS = 0;                                 // 系统含有缓冲区块
 // 改变。使用sleep_on进入睡眠状态的进程需要用wake_up明确地唤醒。
 static inline void wait_on_buffer(struct buffer_head * bh)
 {
+	long start = jiffies;
+
 	cli();                          // 关中断
 	while (bh->b_lock)              // 如果已被上锁则进程进入睡眠，等待其解锁
 		sleep_on(&bh->b_wait);
 	sti();                          // 开中断
+	current->io_wait += jiffies - start;    // 计入等待块设备I/O的时间
 }
 
 //// 设备数据同步。
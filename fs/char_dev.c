@@ -9,35 +9,39 @@
 
 #include <linux/sched.h>
 #include <linux/kernel.h>
+#include <linux/poll.h>
 
 #include <asm/segment.h>
 #include <asm/io.h>
 
-extern int tty_read(unsigned minor,char * buf,int count);
-extern int tty_write(unsigned minor,char * buf,int count);
+extern int tty_read(unsigned minor,char * buf,int count,int flags);
+extern int tty_write(unsigned minor,char * buf,int count,int flags);
 
-// 定义字符设备读写函数指针类型
-typedef int (*crw_ptr)(int rw,unsigned minor,char * buf,int count,off_t * pos);
+// 定义字符设备读写函数指针类型。flags是文件的打开标志(O_NONBLOCK等)。
+typedef int (*crw_ptr)(int rw,unsigned minor,char * buf,int count,off_t * pos,
+	int flags);
 
 //// 串口终端读写操作函数。
 // 参数：rw - 读写命令；minor - 终端子设备号；buf - 缓冲区；count - 读写字节数
 // pos - 读写操作当前指针，对于中断操作，该指针无用
 // 返回：实际读写的字节数。若失败则返回出错码。
-static int rw_ttyx(int rw,unsigned minor,char * buf,int count,off_t * pos)
+static int rw_ttyx(int rw,unsigned minor,char * buf,int count,off_t * pos,
+	int flags)
 {
-	return ((rw==READ)?tty_read(minor,buf,count):
-		tty_write(minor,buf,count));
+	return ((rw==READ)?tty_read(minor,buf,count,flags):
+		tty_write(minor,buf,count,flags));
 }
 
 //// 终端读写操作函数。
 // 同rw_ttyx，只是增加了对进程是否有控制终端的检测。
-static int rw_tty(int rw,unsigned minor,char * buf,int count, off_t * pos)
+static int rw_tty(int rw,unsigned minor,char * buf,int count, off_t * pos,
+	int flags)
 {
     // 若进程没有控制终端，则返回出错号。否则调用终端读写函数rw_ttyx()，
     // 并返回实际读写字节数。
 	if (current->tty<0)
 		return -EPERM;
-	return rw_ttyx(rw,current->tty,buf,count,pos);
+	return rw_ttyx(rw,current->tty,buf,count,pos,flags);
 }
 
 // 内存数据读写
@@ -82,7 +86,8 @@ static int rw_port(int rw,char * buf, int count, off_t * pos)
 }
 
 //// 内存读写操作函数
-static int rw_memory(int rw, unsigned minor, char * buf, int count, off_t * pos)
+static int rw_memory(int rw, unsigned minor, char * buf, int count, off_t * pos,
+	int flags)
 {
     // 根据内存设备子设备号，分别调用不同的内存读写函数。
 	switch(minor) {
@@ -118,7 +123,7 @@ static crw_ptr crw_table[]={
 // 字符设备读写操作函数
 // 参数：rw - 读写命令；dev - 设备号；buf - 缓冲区; count - 读写字节数；pos - 读写指针。
 // 返回：实际读/写字节数
-int rw_char(int rw,int dev, char * buf, int count, off_t * pos)
+int rw_char(int rw,int dev, char * buf, int count, off_t * pos, int flags)
 {
 	crw_ptr call_addr;
 
@@ -128,5 +133,19 @@ int rw_char(int rw,int dev, char * buf, int count, off_t * pos)
 		return -ENODEV;
 	if (!(call_addr=crw_table[MAJOR(dev)]))
 		return -ENODEV;
-	return call_addr(rw,MINOR(dev),buf,count,pos);
+	return call_addr(rw,MINOR(dev),buf,count,pos,flags);
+}
+
+// 字符设备的poll函数。终端查看其队列，其他设备(内存设备等)总是可读写的。
+int char_poll(int dev, int events, struct poll_table * table)
+{
+	switch (MAJOR(dev)) {
+		case 4:		/* /dev/ttyx */
+			return tty_poll(MINOR(dev),events,table);
+		case 5:		/* /dev/tty */
+			if (current->tty < 0)
+				return POLLERR;
+			return tty_poll(current->tty,events,table);
+	}
+	return events & (POLLIN | POLLOUT);
 }
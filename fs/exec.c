@@ -221,7 +221,7 @@ static unsigned long change_ldt(unsigned long text_size,unsigned long * page)
     // 和数据段基址与原程序相同，因此没有必要再重复去设置他们。
 	code_limit = text_size+PAGE_SIZE -1;
 	code_limit &= 0xFFFFF000;
-	data_limit = 0x4000000;
+	data_limit = TASK_SIZE;
 	code_base = get_base(current->ldt[1]);
 	data_base = code_base;
 	set_base(current->ldt[1],code_base);
@@ -528,6 +528,7 @@ restart_interp:
     // 则将其置空，并复位使用了协处理器的标志。
 	free_page_tables(get_base(current->ldt[1]),get_limit(0x0f));
 	free_page_tables(get_base(current->ldt[2]),get_limit(0x17));
+	current->rss = current->shared = 0;
 	if (last_task_used_math == current)
 		last_task_used_math = NULL;
 	current->used_math = 0;
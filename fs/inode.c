@@ -38,7 +38,7 @@ static inline void lock_inode(struct m_inode * inode)
 {
 	cli();
 	while (inode->i_lock)
-		sleep_on(&inode->i_wait);
+		sleep_on_exclusive(&inode->i_wait);
 	inode->i_lock=1;
 	sti();
 }
@@ -234,6 +234,7 @@ void iput(struct m_inode * inode)
     // 并返回。对于管道节点，inode->i_size存放这内存也地址。
 	if (inode->i_pipe) {
 		wake_up(&inode->i_wait);
+		wake_up(&inode->i_wait2);
 		if (--inode->i_count)
 			return;
 		free_page(inode->i_size);
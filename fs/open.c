@@ -257,9 +257,15 @@ int sys_open(const char * filename,int flag,int mode)
 /* ttys are somewhat special (ttyxx major==4, tty major==5) */
 	if (S_ISCHR(inode->i_mode)) {
 		if (MAJOR(inode->i_zone[0])==4) {
+			if ((i=tty_open(MINOR(inode->i_zone[0])))<0) {
+				iput(inode);
+				current->filp[fd]=NULL;
+				f->f_count=0;
+				return i;
+			}
 			if (current->leader && current->tty<0) {
 				current->tty = MINOR(inode->i_zone[0]);
-				tty_table[current->tty].pgrp = current->pgrp;
+				get_tty(current->tty)->pgrp = current->pgrp;
 			}
 		} else if (MAJOR(inode->i_zone[0])==5)
 			if (current->tty<0) {
@@ -318,6 +324,10 @@ int sys_close(unsigned int fd)
 		panic("Close: file count is 0");
 	if (--filp->f_count)
 		return (0);
+    // 最后一次关闭终端设备文件时通知终端驱动(伪终端要用到)。
+	if (S_ISCHR(filp->f_inode->i_mode) &&
+	    MAJOR(filp->f_inode->i_zone[0])==4)
+		tty_release(MINOR(filp->f_inode->i_zone[0]));
 	iput(filp->f_inode);
 	return (0);
 }
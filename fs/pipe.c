@@ -4,15 +4,24 @@
  *  (C) 1991  Linus Torvalds
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 
 #include <linux/sched.h>
 #include <linux/mm.h>	/* for get_free_page */
+#include <linux/poll.h>
 #include <asm/segment.h>
 
+/*
+ * Readers wait on i_wait and writers on i_wait2, so each side only wakes
+ * the other, and a wakeup for one direction can't be taken by a waiter
+ * for the other (or by lock_inode(), which also sleeps on i_wait).
+ */
 //// 管道读操作函数
 // 参数inode是管道对应的i节点，buf是用户数据缓冲区指针，count是读取的字节数。
-int read_pipe(struct m_inode * inode, char * buf, int count)
+// flags是文件的打开标志：设置了O_NONBLOCK时不睡眠，没有数据可读则返回-EAGAIN。
+int read_pipe(struct m_inode * inode, char * buf, int count, int flags)
 {
 	int chars, size, read = 0;
 
@@ -22,9 +31,11 @@ int read_pipe(struct m_inode * inode, char * buf, int count)
     // 节数退出。否则在该i节点上睡眠，等待信息。宏PIPE_SIZE定义在fs.h中。
 	while (count>0) {
 		while (!(size=PIPE_SIZE(*inode))) {
-			wake_up(&inode->i_wait);
+			wake_up(&inode->i_wait2);
 			if (inode->i_count != 2) /* are there any writers? */
 				return read;
+			if (flags & O_NONBLOCK)
+				return read?read:-EAGAIN;
 			sleep_on(&inode->i_wait);
 		}
         // 此时说明管道(缓冲区)中有数据。于是我们取管道尾指针到缓冲区末端的字
@@ -47,14 +58,15 @@ int read_pipe(struct m_inode * inode, char * buf, int count)
 		while (chars-->0)
 			put_fs_byte(((char *)inode->i_size)[size++],buf++);
 	}
-    // 当此次读管道操作结束，则唤醒等待该管道的进程，并返回读取的字节数。
-	wake_up(&inode->i_wait);
+    // 当此次读管道操作结束，则唤醒等待该管道的写进程，并返回读取的字节数。
+	wake_up(&inode->i_wait2);
 	return read;
 }
 
 //// 管道写操作函数。
 // 参数inode是管道对应的i节点，buf是数据缓冲区指针，count是将写入管道的字节数。
-int write_pipe(struct m_inode * inode, char * buf, int count)
+// 设置了O_NONBLOCK时管道满就返回已写入的字节数，一个也没写入则返回-EAGAIN。
+int write_pipe(struct m_inode * inode, char * buf, int count, int flags)
 {
 	int chars, size, written = 0;
 
@@ -71,7 +83,9 @@ int write_pipe(struct m_inode * inode, char * buf, int count)
 				current->signal |= (1<<(SIGPIPE-1));
 				return written?written:-1;
 			}
-			sleep_on(&inode->i_wait);
+			if (flags & O_NONBLOCK)
+				return written?written:-EAGAIN;
+			sleep_on(&inode->i_wait2);
 		}
         // 程序执行到这里表示管道缓冲区中有可写空间size.于是我们管道头指针到缓冲区
         // 末端空间字节数chars。写管道操作是从管道头指针处开始写的。如果chars大于还
@@ -94,11 +108,36 @@ int write_pipe(struct m_inode * inode, char * buf, int count)
 		while (chars-->0)
 			((char *)inode->i_size)[size++]=get_fs_byte(buf++);
 	}
-    // 当此次写管道操作结束，则唤醒等待管道的进程，返回已写入的字节数，退出。
+    // 当此次写管道操作结束，则唤醒等待管道的读进程，返回已写入的字节数，退出。
 	wake_up(&inode->i_wait);
 	return written;
 }
 
+// 管道的poll函数。读写两端共用一个i节点，一端关闭后i_count小于2。按文件的打开方式
+// 区分读端和写端：读端可读时报POLLIN，没有写者时报POLLHUP；写端可写时报POLLOUT，
+// 没有读者时报POLLERR。
+int pipe_poll(struct file * filp, int events, struct poll_table * table)
+{
+	struct m_inode * inode = filp->f_inode;
+	int mask = 0;
+
+	if (filp->f_mode & 1) {
+		poll_wait(&inode->i_wait,table);
+		if (!PIPE_EMPTY(*inode))
+			mask |= POLLIN;
+		if (inode->i_count != 2)	/* no writers */
+			mask |= POLLHUP;
+	}
+	if (filp->f_mode & 2) {
+		poll_wait(&inode->i_wait2,table);
+		if (!PIPE_FULL(*inode))
+			mask |= POLLOUT;
+		if (inode->i_count != 2)	/* no readers */
+			mask |= POLLERR;
+	}
+	return mask & (events | POLLHUP | POLLERR);
+}
+
 //// 创建管道系统调用。
 // 在fildes所指的数组中创建一对文件句柄(描述符)。这对句柄指向一管道i节点。
 // 参数：filedes - 文件句柄数组。fildes[0]用于读管道数据，fildes[1]向管道写入数据。
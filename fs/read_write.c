@@ -13,11 +13,11 @@
 #include <asm/segment.h>
 
 // 字符设备读写函数。
-extern int rw_char(int rw,int dev, char * buf, int count, off_t * pos);
+extern int rw_char(int rw,int dev, char * buf, int count, off_t * pos, int flags);
 // 读管道操作函数。
-extern int read_pipe(struct m_inode * inode, char * buf, int count);
+extern int read_pipe(struct m_inode * inode, char * buf, int count, int flags);
 // 写管道操作函数
-extern int write_pipe(struct m_inode * inode, char * buf, int count);
+extern int write_pipe(struct m_inode * inode, char * buf, int count, int flags);
 // 块设备读操作函数
 extern int block_read(int dev, off_t * pos, char * buf, int count);
 // 块设备写操作函数
@@ -97,9 +97,10 @@ int sys_read(unsigned int fd,char * buf,int count)
 	verify_area(buf,count);
 	inode = file->f_inode;
 	if (inode->i_pipe)
-		return (file->f_mode&1)?read_pipe(inode,buf,count):-EIO;
+		return (file->f_mode&1)?read_pipe(inode,buf,count,file->f_flags):-EIO;
 	if (S_ISCHR(inode->i_mode))
-		return rw_char(READ,inode->i_zone[0],buf,count,&file->f_pos);
+		return rw_char(READ,inode->i_zone[0],buf,count,&file->f_pos,
+			file->f_flags);
 	if (S_ISBLK(inode->i_mode))
 		return block_read(inode->i_zone[0],&file->f_pos,buf,count);
     // 如果是目录文件或者是常规文件，则首先验证读取字节数count的有效性并进行调整(若
@@ -139,9 +140,10 @@ int sys_write(unsigned int fd,char * buf,int count)
     // 字节数退出。若是常规文件，则执行文件写操作，并返回写入的字节数，退出。
 	inode=file->f_inode;
 	if (inode->i_pipe)
-		return (file->f_mode&2)?write_pipe(inode,buf,count):-EIO;
+		return (file->f_mode&2)?write_pipe(inode,buf,count,file->f_flags):-EIO;
 	if (S_ISCHR(inode->i_mode))
-		return rw_char(WRITE,inode->i_zone[0],buf,count,&file->f_pos);
+		return rw_char(WRITE,inode->i_zone[0],buf,count,&file->f_pos,
+			file->f_flags);
 	if (S_ISBLK(inode->i_mode))
 		return block_write(inode->i_zone[0],&file->f_pos,buf,count);
 	if (S_ISREG(inode->i_mode))
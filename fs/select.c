@@ -0,0 +1,208 @@
+/*
+ *  linux/fs/select.c
+ *
+ *  (C) 1991  Linus Torvalds
+ */
+
+/*
+ * select() and poll(). Both end up in do_poll(), which asks each
+ * descriptor's driver what is ready (pipe_poll, char_poll ...), and
+ * if nothing is, sleeps on all of their wait queues at once.
+ */
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/poll.h>
+#include <asm/segment.h>
+#include <asm/system.h>
+
+#define _S(nr) (1<<((nr)-1))
+#define _BLOCKABLE (~(_S(SIGKILL) | _S(SIGSTOP)))
+
+// 把当前任务加入等待队列q，队列项取自table。由各驱动的poll函数调用。
+void poll_wait(struct wait_queue ** q, struct poll_table * table)
+{
+	struct poll_table_entry * e;
+
+	if (!table || !q || table->nr >= NR_POLL_ENTRIES)
+		return;
+	e = table->entry + table->nr++;
+	e->wait.task = current;
+	e->wait.exclusive = 0;
+	e->q = q;
+	add_wait_queue(q,&e->wait);
+}
+
+// 从所有等待队列中摘除，并释放table所在的页面。
+static void free_wait(struct poll_table * table)
+{
+	struct poll_table_entry * e = table->entry + table->nr;
+
+	while (e-- > table->entry)
+		remove_wait_queue(e->q,&e->wait);
+	free_page((unsigned long) table);
+}
+
+// 查询文件描述符fd的状态。普通文件、目录和块设备总是可读写的。
+static int fd_poll(int fd, int events, struct poll_table * table)
+{
+	struct file * f;
+	struct m_inode * inode;
+
+	if (fd < 0 || fd >= NR_OPEN || !(f = current->filp[fd]) ||
+	    !(inode = f->f_inode))
+		return POLLNVAL;
+	if (inode->i_pipe)
+		return pipe_poll(f,events,table);
+	if (S_ISCHR(inode->i_mode))
+		return char_poll(inode->i_zone[0],events,table);
+	return events & (POLLIN | POLLOUT);
+}
+
+/*
+ * Poll the nfds descriptors in fds (a kernel copy) until one of them is
+ * ready, a signal arrives or 'timeout' timer cycles have passed: 0 means
+ * don't wait, -1 wait for ever. Returns the number of ready descriptors.
+ */
+static int do_poll(struct pollfd * fds, int nfds, long long timeout)
+{
+	struct poll_table * table = NULL, * wait;
+	struct hrtimer t;
+	int i, count;
+
+	if (timeout && !(table = (struct poll_table *) get_free_page()))
+		return -ENOMEM;
+	t.fn = NULL;
+	if (timeout > 0) {
+		t.expires = get_cycles() + timeout;
+		t.fn = hrtimer_wakeup;
+		t.data = (long) current;
+		add_hrtimer(&t);
+	}
+	wait = table;
+	for (;;) {
+		current->state = TASK_INTERRUPTIBLE;
+		count = 0;
+		for (i = 0 ; i < nfds ; i++) {
+			fds[i].revents = fd_poll(fds[i].fd,fds[i].events,wait);
+			if (fds[i].revents)
+				count++;
+		}
+		wait = NULL;		/* on all the queues after the first pass */
+		if (count || !timeout || (timeout > 0 && !t.fn) ||
+		    (current->signal & ~(_BLOCKABLE & current->blocked)))
+			break;
+		schedule();
+	}
+	current->state = TASK_RUNNING;
+	del_hrtimer(&t);
+	if (table)
+		free_wait(table);
+	if (!count && (current->signal & ~(_BLOCKABLE & current->blocked)))
+		return -EINTR;
+	return count;
+}
+
+// 系统调用 - 等待一组文件描述符中的任何一个就绪。timeout以毫秒计，-1表示一直等待。
+int sys_poll(struct pollfd * ufds, unsigned long nfds, int timeout)
+{
+	struct pollfd fds[NR_OPEN];
+	long long cycles = -1;
+	int i, count;
+
+	if (nfds > NR_OPEN)
+		return -EINVAL;
+	for (i = 0 ; i < nfds ; i++) {
+		fds[i].fd = get_fs_long((unsigned long *) &ufds[i].fd);
+		fds[i].events = get_fs_word((unsigned short *) &ufds[i].events);
+	}
+/* cycles = ms * CLOCK_TICK_RATE / 1000, again without a 64-bit divide */
+	if (timeout >= 0)
+		cycles = (timeout / 1000) * (long long) CLOCK_TICK_RATE +
+			(((timeout % 1000) * 5124670458000ULL) >> 32);
+	if ((count = do_poll(fds,nfds,cycles)) < 0)
+		return count;
+	verify_area(ufds,nfds * sizeof(struct pollfd));
+	for (i = 0 ; i < nfds ; i++)
+		put_fs_word(fds[i].revents,(short *) &ufds[i].revents);
+	return count;
+}
+
+/*
+ * select() has five arguments, so it gets them in a block:
+ * n, readfds, writefds, exceptfds, timeout (see lib/select.c).
+ */
+int sys_select(unsigned long * buffer)
+{
+	struct pollfd fds[NR_OPEN];
+	fd_set * sets[3];
+	unsigned long in[3], out[3] = {0,0,0};
+	struct timeval * tvp;
+	long long cycles = -1;
+	long sec, usec;
+	int n, i, j, nfds, count;
+
+	n = get_fs_long(buffer);
+	for (j = 0 ; j < 3 ; j++) {
+		sets[j] = (fd_set *) get_fs_long(buffer+1+j);
+		in[j] = sets[j] ? get_fs_long(sets[j]->fds_bits) : 0;
+	}
+	tvp = (struct timeval *) get_fs_long(buffer+4);
+	if (n < 0)
+		return -EINVAL;
+	if (n > NR_OPEN)
+		n = NR_OPEN;
+	for (i = nfds = 0 ; i < n ; i++) {
+		if (!((in[0] | in[1] | in[2]) & (1UL << i)))
+			continue;
+		if (!current->filp[i])
+			return -EBADF;
+		fds[nfds].fd = i;
+		fds[nfds].events = 0;
+		if (in[0] & (1UL << i))
+			fds[nfds].events |= POLLIN;
+		if (in[1] & (1UL << i))
+			fds[nfds].events |= POLLOUT;
+		if (in[2] & (1UL << i))
+			fds[nfds].events |= POLLPRI;
+		nfds++;
+	}
+/* cycles = usec * CLOCK_TICK_RATE / 10^6 */
+	if (tvp) {
+		sec = get_fs_long((unsigned long *) &tvp->tv_sec);
+		usec = get_fs_long((unsigned long *) &tvp->tv_usec);
+		if (sec < 0 || usec < 0 || usec >= 1000000)
+			return -EINVAL;
+		cycles = sec * (long long) CLOCK_TICK_RATE +
+			((usec * 5124670458ULL) >> 32);
+	}
+	if ((count = do_poll(fds,nfds,cycles)) < 0)
+		return count;
+// 一个描述符在几个集合中就绪时，select()在每个集合中都算一次。
+	count = 0;
+	for (i = 0 ; i < nfds ; i++) {
+		j = 1UL << fds[i].fd;
+		if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) && (in[0] & j)) {
+			out[0] |= j;
+			count++;
+		}
+		if ((fds[i].revents & (POLLOUT | POLLERR)) && (in[1] & j)) {
+			out[1] |= j;
+			count++;
+		}
+		if ((fds[i].revents & POLLPRI) && (in[2] & j)) {
+			out[2] |= j;
+			count++;
+		}
+	}
+	for (j = 0 ; j < 3 ; j++)
+		if (sets[j]) {
+			verify_area(sets[j],sizeof(fd_set));
+			put_fs_long(out[j],sets[j]->fds_bits);
+		}
+	return count;
+}
@@ -45,8 +45,8 @@ int ROOT_DEV = 0;       // 根文件系统设备号。
 static void lock_super(struct super_block * sb)
 {
 	cli();                          // 关中断
-	while (sb->s_lock)              // 如果该超级块已经上锁，则睡眠等待。
-		sleep_on(&(sb->s_wait));
+	while (sb->s_lock)              // 如果该超级块已经上锁，则睡眠等待（互斥等待）。
+		sleep_on_exclusive(&(sb->s_wait));
 	sb->s_lock = 1;                 // 会给超级块加锁（置锁定标志）
 	sti();                          // 开中断
 }
@@ -37,6 +37,25 @@ static inline void put_fs_long(unsigned long val,unsigned long * addr)
 __asm__ ("movl %0,%%fs:%1"::"r" (val),"m" (*addr));
 }
 
+/*
+ * Copy n bytes from kernel space to the user space at fs:to; the
+ * caller has done verify_area().
+ */
+static inline void memcpy_tofs(void * to, const void * from, unsigned long n)
+{
+__asm__ volatile ("push %%es\n\t"
+	"push %%fs\n\t"
+	"pop %%es\n\t"
+	"cld\n\t"
+	"rep ; movsl\n\t"
+	"movl %3,%%ecx\n\t"
+	"rep ; movsb\n\t"
+	"pop %%es"
+	:"=c" (n),"=D" (to),"=S" (from)
+	:"r" (n & 3),"0" (n >> 2),"1" (to),"2" (from)
+	:"memory");
+}
+
 /*
  * Someone who knows GNU asm better than I should double check the followig.
  * It seems to work, but I don't know if I'm doing something subtly wrong.
@@ -17,8 +17,18 @@ __asm__ ("movl %%esp,%%eax\n\t" \
 #define cli() __asm__ ("cli"::)		// 这里的cli只会修改CPSR(即当前进程状态寄存器)，因此不会影响其它进程接收中断
 #define nop() __asm__ ("nop"::)
 
+// 保存/恢复标志寄存器(含中断允许位IF)，用于可嵌套的关中断临界区。
+#define save_flags(x) \
+__asm__ __volatile__("pushfl ; popl %0":"=r" (x))
+#define restore_flags(x) \
+__asm__ __volatile__("pushl %0 ; popfl"::"r" (x))
+
 #define iret() __asm__ ("iret"::)
 
+// 写模型专用寄存器(MSR)。
+#define wrmsr(msr,lo,hi) \
+__asm__ __volatile__("wrmsr"::"c" (msr),"a" (lo),"d" (hi))
+
 #define _set_gate(gate_addr,type,dpl,addr) \
 __asm__ ("movw %%dx,%%ax\n\t" \
 	"movw %0,%%dx\n\t" \
@@ -40,6 +40,10 @@
 #define WIN_SEEK 		0x70
 #define WIN_DIAGNOSE		0x90
 #define WIN_SPECIFY		0x91
+#define WIN_MULTREAD		0xC4	/* read/write several sectors per interrupt */
+#define WIN_MULTWRITE		0xC5
+#define WIN_SETMULT		0xC6	/* set sectors per interrupt for the above */
+#define WIN_IDENTIFY		0xEC	/* ask drive for its parameters */
 
 /* Bits for HD_ERROR */
 #define MARK_ERR	0x01	/* Bad address mark ? */
@@ -7,6 +7,9 @@ typedef struct desc_struct {
 
 extern unsigned long pg_dir[1024];
 extern desc_table idt,gdt;
+extern long x86;		/* cpu family: 3, 4, 5 ... */
+extern long x86_model, x86_mask;	/* model and stepping */
+extern long x86_capability;	/* cpuid feature flags */
 
 #define GDT_NUL 0
 #define GDT_CODE 1
@@ -6,5 +6,8 @@
 extern unsigned long get_free_page(void);
 extern unsigned long put_page(unsigned long page,unsigned long address);
 extern void free_page(unsigned long addr);
+extern unsigned long get_free_pages(int order);
+extern void free_pages(unsigned long addr, int order);
+extern void zero_idle_page(void);
 
 #endif
@@ -0,0 +1,36 @@
+#ifndef _LINUX_POLL_H
+#define _LINUX_POLL_H
+
+#include <poll.h>
+#include <linux/wait.h>
+#include <linux/mm.h>
+
+/*
+ * While select() or poll() sleeps, the caller is on the wait queue of
+ * every descriptor it looks at. The entries live in one page, which
+ * poll_wait() fills in and fs/select.c frees when the call is over.
+ */
+struct poll_table_entry {
+	struct wait_queue wait;
+	struct wait_queue ** q;
+};
+
+struct poll_table {
+	int nr;
+	struct poll_table_entry entry[1];
+};
+
+#define NR_POLL_ENTRIES \
+	((PAGE_SIZE - sizeof(int)) / sizeof(struct poll_table_entry))
+
+/* a NULL table means "don't wait", just check */
+extern void poll_wait(struct wait_queue ** q, struct poll_table * table);
+
+struct file;
+
+/* the per-driver hooks: return the POLLxxx bits that are true now */
+extern int pipe_poll(struct file * filp, int events, struct poll_table * table);
+extern int char_poll(int dev, int events, struct poll_table * table);
+extern int tty_poll(unsigned channel, int events, struct poll_table * table);
+
+#endif
@@ -1,16 +1,28 @@
 #ifndef _SCHED_H
 #define _SCHED_H
 
-#define NR_TASKS 64		// 系统中同时最多任务（进程）数
+#define NR_TASKS 4096		// 系统中同时最多任务（进程）数
 #define HZ 100			// 定义系统时钟滴答，10ms一次
+#define CLOCK_TICK_RATE 1193180	// 8253/8254定时芯片的输入时钟频率
 
-#define FIRST_TASK task[0]			// 任务0比较特殊，所以特意给它单独定义一个符号
-#define LAST_TASK task[NR_TASKS-1]	// 任务数组中的最后一项任务
+#define PID_MAX 32768		// 进程号取值范围1 - PID_MAX-1
+#define PIDHASH_SZ 256		// 进程号散列表大小，必须是2的幂
+#define pid_hashfn(x) ((((x) >> 8) ^ (x)) & (PIDHASH_SZ - 1))
+
+#define FIRST_TASK (&init_task.task)	// 任务0比较特殊，所以特意给它单独定义一个符号
+
+/*
+ * Every user task runs at the same linear base, each in its own page
+ * directory. Below TASK_BASE every directory maps the kernel.
+ */
+#define TASK_BASE 0x4000000
+#define TASK_SIZE 0x4000000
 
 #include <linux/head.h>
 #include <linux/fs.h>
 #include <linux/mm.h>
 #include <signal.h>
+#include <sys/resource.h>
 
 #if (NR_OPEN > 32)
 #error "Currently the close-on-exec-flags are in one word, max 32 files/proc"
@@ -27,10 +39,16 @@
 #define NULL ((void *) 0)			// 定义NULL为空指针
 #endif
 
+struct task_struct;
+
 // 复制进程的页目录页表（mm/memory.c）
-extern int copy_page_tables(unsigned long from, unsigned long to, long size);
+extern int copy_page_tables(unsigned long from, unsigned long to, long size,
+	struct task_struct * p);
 // 释放页表所指定的内存块及页表本身
 extern int free_page_tables(unsigned long from, unsigned long size);
+// 为新任务申请/释放页目录
+extern unsigned long new_page_dir(void);
+extern void free_page_dir(struct task_struct * p);
 
 // 调度程序的初始化函数
 extern void sched_init(void);
@@ -43,7 +61,7 @@ extern void trap_init(void);
 volatile void panic(const char * str);
 #endif
 // 往tty上写指定长度的字符串
-extern int tty_write(unsigned minor,char * buf,int count);
+extern int tty_write(unsigned minor,char * buf,int count,int flags);
 
 typedef int (*fn_ptr)();
 
@@ -59,7 +77,7 @@ struct i387_struct {
 	long	st_space[20];	/* 8*10 bytes for each FP-reg = 80 bytes */
 };							// 8个10字节的协处理器累加器
 
-// 任务状态段数据结构
+// 任务状态段数据结构。整个系统只有一个TSS（见kernel/sched.c），CPU只用其中的esp0/ss0
 struct tss_struct {
 	long	back_link;	/* 16 high bits zero */
 	long	esp0;
@@ -84,6 +102,43 @@ struct tss_struct {
 	long	gs;		/* 16 high bits zero */
 	long	ldt;		/* 16 high bits zero */
 	long	trace_bitmap;	/* bits: trace 0, bitmap 16-31 */
+};
+
+/*
+ * A fair-share scheduling group (see <sched.h>). sched_groups[0] holds
+ * every task while grouping is off, and catches the overflow when there
+ * are more groups than NR_GROUPS.
+ */
+#define NR_GROUPS 64
+
+struct sched_group {
+	long id;			// 会话号、进程组号或用户号，取决于sched_group_mode
+	long counter;			// 本组剩余的运行时间片(滴答数)
+	long weight;			// 每轮分给本组的滴答数
+	int nr_tasks;			// 组内任务数，为0表示该项空闲
+};
+
+/*
+ * A pending real-time signal. Sending one fails with EAGAIN while the
+ * task has NR_SIGQUEUE of them pending. The queue lives in the task_struct
+ * page with the kernel stack, so it is kept to one entry per RT signal.
+ */
+#define NR_SIGQUEUE (SIGRTMAX-SIGRTMIN+1)
+
+struct sigq_entry {
+	long sig;
+	long value;
+};
+
+/*
+ * What switch_to() keeps for a task that isn't running. Everything
+ * else lives on its kernel stack.
+ */
+struct thread_struct {
+	long	esp0;		/* top of the kernel stack, goes into tss.esp0 */
+	long	esp;		/* kernel stack pointer while switched out */
+	long	eip;		/* where switch_to() resumes it */
+	long	cr3;		/* page directory */
 	struct i387_struct i387;
 };
 
@@ -101,6 +156,8 @@ struct task_struct {
 	unsigned long start_code,end_code,end_data,brk,start_stack;	
 	// 进程标识号，父进程号，进程组号，会话号，会话首领
 	long pid,father,pgrp,session,leader;
+	// 任务链表的前后指针，以及进程号散列链
+	struct task_struct *next_task,*prev_task,*next_hash;
 	// 用户id，有效用户id，保存的用户id
 	unsigned short uid,euid,suid;
 	// 组id，有效组id，保存的组id
@@ -108,7 +165,22 @@ struct task_struct {
 	long alarm; 	//报警定时值
 	// 用户态运行时间(滴答数)，系统态运行时间，子进程用户态运行时间，子进程系统态运行时间，进程开始运行时刻
 	long utime,stime,cutime,cstime,start_time;
+/* statistics, see <sys/taskstats.h> */
+	long ready_since;				// 最近一次进入就绪状态时的jiffies
+	long wait_time,io_wait;			// 就绪但未运行的滴答数，等待块设备I/O的滴答数
+	long nvcsw,nivcsw;				// 自愿(睡眠)和被迫(被抢占)的切换次数
+	long min_flt,maj_flt;			// 不需要/需要读盘的缺页次数
+	long trace_nr;					// 正被跟踪的系统调用号，-1表示没有，见kernel/systrace.c
+	unsigned long trace_start;		// 该系统调用的开始时刻(定时器时钟周期)
 	unsigned short used_math;		// 是否使用了协处理器
+	struct sched_group * group;		// 公平调度时本任务所属的组
+	long policy,rt_priority;		// 调度策略(SCHED_xxx)，实时优先级(1-99，普通任务为0)
+/* queued real-time signals, see kernel/signal.c */
+	struct sigq_entry sigq[NR_SIGQUEUE];	// 按发送顺序排列的实时信号及其附带的值
+	long sigq_nr;					// 队列中的信号数
+/* memory accounting */
+	long rss,shared;				// 驻留内存页面数，其中与其他进程共享的页面数
+	struct rlimit rlim[RLIM_NLIMITS];	// 资源限制
 /* file system info */
 	int tty;						// 进程使用tty的子设备号，-1表示没有使用
 	unsigned short umask;			// 文件创建属性屏蔽位
@@ -119,10 +191,15 @@ struct task_struct {
 	struct file * filp[NR_OPEN];	// 进程使用的文件表结构
 /* ldt for this task 0 - zero 1 - cs 2 - ds&ss */
 	struct desc_struct ldt[3];		// 本任务的局部表描述符。0-空，1-代码段cs，2-数据和堆栈段ds&ss
-/* tss for this task */
-	struct tss_struct tss;			// 本进程的任务状态段信息结构
+/* kernel context for switch_to */
+	struct thread_struct thread;	// 本进程被切换出去时保存的内核栈指针、恢复地址及协处理器状态
 };
 
+#define INIT_RLIMITS { \
+	{RLIM_INFINITY,RLIM_INFINITY}, {RLIM_INFINITY,RLIM_INFINITY}, \
+	{RLIM_INFINITY,RLIM_INFINITY}, {RLIM_INFINITY,RLIM_INFINITY}, \
+	{RLIM_INFINITY,RLIM_INFINITY}, {RLIM_INFINITY,RLIM_INFINITY} }
+
 /*
  *  INIT_TASK is used to set up the first task table, touch at
  * your own risk!. Base=0, limit=0x9ffff (=640kB)
@@ -132,9 +209,15 @@ struct task_struct {
 /* signals */	0,{{},},0, \		// signal，sigaction[32]，blocked
 /* ec,brk... */	0,0,0,0,0,0, \		// exit_code，start_code，end_code，end_data，brk，start_stack
 /* pid etc.. */	0,-1,0,0,0, \		// pid， father，pgrp，session，leader
+/* links */	&init_task.task,&init_task.task,NULL, \	// next_task，prev_task，next_hash
 /* uid etc */	0,0,0,0,0,0, \		// uid，euid，suid，gid，egid，sgid
 /* alarm */	0,0,0,0,0,0, \			// alam，utime，stime，cutime，cstime，start_time
+/* stats */	0,0,0,0,0,0,0,-1,0, \		// ready_since，wait_time，io_wait，nvcsw，nivcsw，min_flt，maj_flt，trace_nr，trace_start
 /* math */	0, \					// used_math
+/* group */	sched_groups,0,0, \		// group，policy，rt_priority
+/* sigq */	{{0,0},},0, \			// sigq[NR_SIGQUEUE]，sigq_nr
+/* rss */	0,0, \					// rss，shared
+/* rlimits */	INIT_RLIMITS, \		// rlim[6]
 /* fs info */	-1,0022,NULL,NULL,NULL,0, \		// tty，umask，pwd，root，executable，close_on_exec
 /* filp */	{NULL,}, \				// filp[20]
 	{ \								// ldt[3]
@@ -142,17 +225,29 @@ struct task_struct {
 /* ldt */	{0x9f,0xc0fa00}, \		// 代码长640K，基址0x0,G=1,D=1,DPL=3,P=1 TYPE=0x0a
 		{0x9f,0xc0f200}, \			// 数据长640K，基址0x0,G=1,D=1,DPL=3,P=1 TYPE=0x02
 	}, \
-/*tss*/	{0,PAGE_SIZE+(long)&init_task,0x10,0,0,0,0,(long)&pg_dir,\
-	 0,0,0,0,0,0,0,0, \
-	 0,0,0x17,0x17,0x17,0x17,0x17,0x17, \
-	 _LDT(0),0x80000000, \
-		{} \
-	}, \
+/*thread*/	{PAGE_SIZE+(long)&init_task,0,0,(long)&pg_dir,{}}, \
 }
 
-extern struct task_struct *task[NR_TASKS];			// 任务指针数组
+/*
+ * Each task's kernel stack lives in the same page as its task_struct.
+ */
+union task_union {
+	struct task_struct task;
+	char stack[PAGE_SIZE];
+};
+
+extern union task_union init_task;					// 任务0，同时是任务链表的表头
+extern struct task_struct *pidhash[PIDHASH_SZ];		// 进程号散列表
+extern int nr_tasks;								// 现有任务数
+extern struct sched_group sched_groups[NR_GROUPS];	// 公平调度组
+extern int sched_group_mode;						// 分组方式(SCHED_GROUP_xxx)
+extern void sched_regroup(struct task_struct * p);	// 按当前分组方式重新确定p所在的组
+extern int need_resched;							// 有更高优先级的实时任务就绪，需要重新调度
+extern void wake_up_process(struct task_struct * p);	// 唤醒一个任务，必要时置need_resched
+extern int queue_signal(struct task_struct * p, int sig, long value);	// 发送信号，实时信号排队
 extern struct task_struct *last_task_used_math;		// 上一个使用过协处理器的进程
 extern struct task_struct *current;					// 当前进程结构指针变量
+extern struct tss_struct tss;						// 系统唯一的任务状态段
 extern long volatile jiffies;						// 从开机开始算起的滴答数
 extern long startup_time;							// 开机时间，从1970:0:0:0开始计时的秒数
 
@@ -160,73 +255,136 @@ extern long startup_time;							// 开机时间，从1970:0:0:0开始计时的
 
 // 添加定时器函数（定时时间jiffies滴答数，定时到时调用函数*fn()）
 extern void add_timer(long jiffies, void (*fn)(void));
+
+/*
+ * High-resolution timers. 'expires' is an absolute time in PIT cycles
+ * (CLOCK_TICK_RATE per second, see get_cycles()). The structure belongs
+ * to the caller; fn is cleared just before it is called from the timer
+ * interrupt, so a non-NULL fn means the timer is still pending.
+ */
+struct hrtimer {
+	unsigned long long expires;
+	void (*fn)(long);
+	long data;
+	struct hrtimer * next;
+};
+
+extern unsigned long long get_cycles(void);
+extern void add_hrtimer(struct hrtimer * t);
+extern void del_hrtimer(struct hrtimer * t);
+extern void hrtimer_wakeup(long data);		// data是要唤醒的任务
+// 空闲任务停掉周期时钟并hlt，直到有任务就绪
+extern void tick_idle(void);
 // 不可中断的等待睡眠
-extern void sleep_on(struct task_struct ** p);
+extern void sleep_on(struct wait_queue ** q);
 // 可中断的等待睡眠
-extern void interruptible_sleep_on(struct task_struct ** p);
+extern void interruptible_sleep_on(struct wait_queue ** q);
+// 互斥的不可中断睡眠，每次wake_up只唤醒一个
+extern void sleep_on_exclusive(struct wait_queue ** q);
 // 明确唤醒睡眠的进程
-extern void wake_up(struct task_struct ** p);
+extern void wake_up(struct wait_queue ** q);
+// 不睡眠地加入/离开等待队列，用于同时等待多个队列
+extern void add_wait_queue(struct wait_queue ** q, struct wait_queue * wait);
+extern void remove_wait_queue(struct wait_queue ** q, struct wait_queue * wait);
+// 按进程号查找任务（kernel/fork.c）
+extern struct task_struct * find_task_by_pid(long pid);
+extern void unhash_pid(struct task_struct * p);
 
 /*
- * Entry into gdt where to find first TSS. 0-nul, 1-cs, 2-ds, 3-syscall
- * 4-TSS0, 5-LDT0, 6-TSS1 etc ...
+ * All tasks are on a circular list headed by task 0. for_each_task()
+ * walks everybody but task 0, which is never a valid target for
+ * signals, wait() or the scheduler proper.
  */
-// 全局表中第1个任务状态段(TSS)描述符的选择符索引号
-#define FIRST_TSS_ENTRY 4
-// 全局表中第1个局部描述符表(LDT)描述符的选择符索引号
-#define FIRST_LDT_ENTRY (FIRST_TSS_ENTRY+1)
-// 计算全局表中第n个任务的TSS段描述符的选择符值（偏移量）
-// 因每个描述符占8字节，因此FIRST_TSS_ENTRY<<3表示该描述符在GDT表中的起始偏移位置
-// 因为每个任务使用1个TSS和1个LDT描述符，共占16字节，因此需要n<<4来表示对应TSS起始
-// 位置。该宏得到的值正好也是该TSS的选择符值。
-#define _TSS(n) ((((unsigned long) n)<<4)+(FIRST_TSS_ENTRY<<3))
-// 计算全局表中第n个任务的LDT段描述符的选择符值（偏移值）
-#define _LDT(n) ((((unsigned long) n)<<4)+(FIRST_LDT_ENTRY<<3))
-// 把第n个任务的TSS段选择符加载到任务寄存器TR中
-#define ltr(n) __asm__("ltr %%ax"::"a" (_TSS(n)))
-// 把第n个任务的LDT段选择符加载到局部描述符表寄存器LDTR中。
-#define lldt(n) __asm__("lldt %%ax"::"a" (_LDT(n)))
-// 取当前运行任务的任务号（是任务数组中的索引值，与进程号pid不同）
-// 返回：n-当前任务号
-#define str(n) \
-__asm__("str %%ax\n\t" \		// 将任务寄存器中TSS段的选择符复制到ax中
-	"subl %2,%%eax\n\t" \		// (eax - FIRST_TSS_ENTRY * 8)->eax
-	"shrl $4,%%eax" \			// (eax / 16)->eax = 当前任务号
-	:"=a" (n) \
-	:"a" (0),"i" (FIRST_TSS_ENTRY<<3))
+#define for_each_task(p) \
+	for (p = FIRST_TASK ; (p = p->next_task) != FIRST_TASK ; )
+
+#define SET_LINKS(p) { \
+	(p)->next_task = FIRST_TASK; \
+	(p)->prev_task = FIRST_TASK->prev_task; \
+	FIRST_TASK->prev_task->next_task = (p); \
+	FIRST_TASK->prev_task = (p); }
+
+#define REMOVE_LINKS(p) { \
+	(p)->next_task->prev_task = (p)->prev_task; \
+	(p)->prev_task->next_task = (p)->next_task; }
+
 /*
- *	switch_to(n) should switch tasks to task nr n, first
- * checking that n isn't the current task, in which case it does nothing.
- * This also clears the TS-flag(cr0) if the task we switched to has used
- * tha math co-processor latest.
+ * Entry into gdt where to find the TSS and the LDT. 0-nul, 1-cs, 2-ds,
+ * 3-syscall, 4-TSS, 5-LDT. There is only one of each: switch_to() points
+ * the LDT descriptor at the next task's ldt[] and reloads it, so the
+ * number of tasks has nothing to do with the size of the gdt.
  */
-// 跳转到一个任务的TSS段选择符组成的地址处会造成CPU进行任务切换操作。
-// 输入：	%0 - 指向__tmp;			%1 - 指向__tmp.b处，用于存放新TSS的选择符
-//			dx - 新任务n的TSS段选择符	ecx - 新任务n的任务结构指针task[n]
-// 其中临时数据结构__tmp用于组建远跳转(ljmp)指令的操作数。该操作数由4字节偏移地址和2
-// 字节的段选择符组成。因此__tmp中a的值是32为偏移值，而b的低2字节是新TSS段的选择符
-// (高2字节不用)。跳转到TSS端选择符会造成任务切换到该TSS对应的进程。对于造成任务切换
-// 的长跳转，a值无用。ljmp内存间接跳转指令使用6字节操作数作为跳转目的地的长指针，其格
-// 式为：jmp 16位段选择符:32位偏移值。但在内存中操作数的表示顺序与这里正好相反。
-// 任务切换回来后，在判断原任务上次执行是否使用过协处理器时，是哦嗯过将原任务指针与保存
-// 在last_task_used_math变量中的上次使用过协处理器任务指针进行比较而作出的，参见文件
-// kernel/sched.c中有关math_state_restore()函数的说明。
-#define switch_to(n) {\
-struct {long a,b;} __tmp; \
-__asm__("cmpl %%ecx,current\n\t" \			// 任务n是当前任务么?(current==task[n]?)
-	"je 1f\n\t" \							// 跳转退出
-	"movw %%dx,%1\n\t" \					// 将新任务TSS的16位选择符存入__tmp.b中
-	"xchgl %%ecx,current\n\t" \				// current=task[n]; ecx=被切换出的任务
-	"ljmp *%0\n\t" \						// 执行长跳转至 *&__tmp，造成任务切换
-	"cmpl %%ecx,last_task_used_math\n\t" \	// 原任务上次使用过协处理器么？
-	"jne 1f\n\t" \							// 跳转退出
-	"clts\n" \								// 清除cr0中的任务切换
-	"1:" \									// 标志TS。
-	::"m" (*&__tmp.a),"m" (*&__tmp.b), \	// 第1个":"表示输出寄存器为空。第二个冒号表示输入寄存器，
-	"d" (_TSS(n)),"c" ((long) task[n])); \	// %0   内存地址    __tmp.a的地址，用来放偏移
-}											// %1   内存地址    __tmp.b的地址，用来放TSS选择符
-											// %2   edx         任务号为n的TSS选择符
-											// %3   ecx         task[n] 
+#define TSS_ENTRY 4
+#define LDT_ENTRY 5
+#define _TSS (TSS_ENTRY<<3)
+#define _LDT (LDT_ENTRY<<3)
+#define ltr() __asm__("ltr %%ax"::"a" (_TSS))
+#define lldt() __asm__("lldt %%ax"::"a" (_LDT))
+
+#define THREAD_OFF(field) ((long) &((struct task_struct *) 0)->thread.field)
+
+/*
+ *	switch_to(next) should switch to task 'next', first
+ * checking that it isn't the current task, in which case it does nothing.
+ *
+ * This is done in software: the old task's eflags, ebp, fs and gs go on
+ * its kernel stack and the stack pointer into current->thread, then we
+ * load the new task's page directory (if it differs) and stack and jump to its thread.eip - label 2 below
+ * for anything that has been switched out before, ret_from_fork for a
+ * new child. Interrupts stay off until the new stack is in place, as
+ * esp0 and the LDT have already been changed by then.
+ *
+ * TS is set whenever we leave the co-processor owner so the next user
+ * traps into math_state_restore(), and cleared again when we come back
+ * to the task that owns it (last_task_used_math).
+ */
+#define switch_to(next) {\
+long __ecx; \
+__asm__ __volatile__("cmpl %%ecx,current\n\t" \
+	"je 1f\n\t" \
+	"pushfl\n\t" \
+	"cli\n\t" \
+	"pushl %%ebp\n\t" \
+	"push %%fs\n\t" \
+	"push %%gs\n\t" \
+	"movl current,%%eax\n\t" \
+	"movl %%cr0,%%edx\n\t" \
+	"testl $8,%%edx\n\t" \
+	"jne 3f\n\t" \
+	"orl $8,%%edx\n\t" \
+	"movl %%edx,%%cr0\n" \
+	"3:\tmovl %%esp,%c2(%%eax)\n\t" \
+	"movl $2f,%c3(%%eax)\n\t" \
+	"movl %c7(%%ecx),%%edx\n\t" \
+	"cmpl %%edx,%c7(%%eax)\n\t" \
+	"je 5f\n\t" \
+	"movl %%edx,%%cr3\n" \
+	"5:\tmovl %%ecx,current\n\t" \
+	"movl %c1(%%ecx),%%edx\n\t" \
+	"movl %%edx,tss+4\n\t" \
+	"leal %c4(%%ecx),%%eax\n\t" \
+	"movw %%ax,gdt+%c5+2\n\t" \
+	"rorl $16,%%eax\n\t" \
+	"movb %%al,gdt+%c5+4\n\t" \
+	"movb %%ah,gdt+%c5+7\n\t" \
+	"movl %5,%%eax\n\t" \
+	"lldt %%ax\n\t" \
+	"movl %c2(%%ecx),%%esp\n\t" \
+	"jmp *%c3(%%ecx)\n" \
+	"2:\tcmpl %%ecx,last_task_used_math\n\t" \
+	"jne 4f\n\t" \
+	"clts\n" \
+	"4:\tpop %%gs\n\t" \
+	"pop %%fs\n\t" \
+	"popl %%ebp\n\t" \
+	"popfl\n" \
+	"1:" \
+	:"=c" (__ecx) \
+	:"i" (THREAD_OFF(esp0)),"i" (THREAD_OFF(esp)), \
+	"i" (THREAD_OFF(eip)),"i" ((long) &((struct task_struct *) 0)->ldt), \
+	"i" (_LDT),"0" ((long) (next)),"i" (THREAD_OFF(cr3)) \
+	:"ax","bx","dx","si","di","memory"); \
+}
 
 // 页面地址对齐（内核代码中没有任何地方引用）
 #define PAGE_ALIGN(n) (((n)+0xfff)&0xfffff000)
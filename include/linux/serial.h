@@ -0,0 +1,36 @@
+#ifndef _LINUX_SERIAL_H
+#define _LINUX_SERIAL_H
+
+/* uart types */
+#define PORT_UNKNOWN	0
+#define PORT_16450	1	/* 8250/16450: no fifo */
+#define PORT_16550	2	/* fifo present but unusable */
+#define PORT_16550A	3	/* working 16 byte fifos */
+
+/* argument of TIOCGSERIAL/TIOCSSERIAL; TIOCSSERIAL only sets rx_trigger */
+struct serial_struct {
+	int type;
+	int xmit_fifo_size;	/* chars sent per transmit interrupt */
+	int rx_trigger;		/* receive interrupt after 1, 4, 8 or 14 chars */
+	unsigned long overrun;	/* chars the uart lost before we read them */
+	unsigned long dropped;	/* chars lost because the read queue was full */
+};
+
+/*
+ * Per-line driver state, indexed by tty line. rs_io.s hardwires its
+ * size and the offsets of xmit_fifo, overrun and dropped.
+ */
+struct rs_info {
+	unsigned long xmit_fifo;
+	unsigned long overrun;
+	unsigned long dropped;
+	unsigned long type;
+	unsigned long rx_trigger;
+};
+
+extern struct rs_info rs_info[];
+
+int rs_get_serial(int line, struct serial_struct * ss);
+int rs_set_serial(int line, struct serial_struct * ss);
+
+#endif
@@ -10,28 +10,60 @@
 #define _TTY_H
 
 #include <termios.h>
+#include <linux/wait.h>
 
-#define TTY_BUF_SIZE 1024
+#define TTY_BUF_SIZE 1024		/* default (and smallest) queue size */
+#define TTY_BUF_MAX 65536
 
+/*
+ * tty minors: 0 is the first console and 1-2 the serial lines, as they
+ * always were. The other virtual consoles follow from minor 3 on.
+ */
+#define NR_CONSOLES	4		/* at most, fewer if video memory is short */
+#define NR_SERIAL	2
+#define NR_TTYS		(NR_SERIAL+NR_CONSOLES)
+
+#define CON_MINOR(n)	((n) ? (n)+NR_SERIAL : 0)
+#define MINOR_CON(m)	((m) ? (m)-NR_SERIAL : 0)
+#define IS_CONSOLE(m)	(!(m) || ((m) > NR_SERIAL && (m) < NR_TTYS))
+
+/*
+ * Pseudo terminals: master n is minor PTY_MASTER+n, its slave minor
+ * PTY_SLAVE+n. A pair is allocated when the master is opened and
+ * freed when both sides are closed again.
+ */
+#define NR_PTYS		64
+#define PTY_MASTER	128
+#define PTY_SLAVE	(PTY_MASTER+NR_PTYS)
+#define IS_PTY(m)	((m) >= PTY_MASTER && (m) < PTY_SLAVE+NR_PTYS)
+
+/*
+ * Queue sizes are powers of two and can be changed with TIOCSQSIZE.
+ * buf points to init_buf until a queue is made larger than the default.
+ */
 struct tty_queue {
 	unsigned long data;
 	unsigned long head;
 	unsigned long tail;
-	struct task_struct * proc_list;
-	char buf[TTY_BUF_SIZE];
+	struct wait_queue * proc_list;
+	char * buf;
+	unsigned long mask;		/* size-1 */
+	unsigned long busy;		/* read_raw() copying out of buf */
+	char init_buf[TTY_BUF_SIZE];
 };
 
-#define INC(a) ((a) = ((a)+1) & (TTY_BUF_SIZE-1))
-#define DEC(a) ((a) = ((a)-1) & (TTY_BUF_SIZE-1))
+#define QSIZE(a) ((a).mask+1)
+#define INC(q,a) ((a) = ((a)+1) & (q).mask)
+#define DEC(q,a) ((a) = ((a)-1) & (q).mask)
 #define EMPTY(a) ((a).head == (a).tail)
-#define LEFT(a) (((a).tail-(a).head-1)&(TTY_BUF_SIZE-1))
-#define LAST(a) ((a).buf[(TTY_BUF_SIZE-1)&((a).head-1)])
+#define LEFT(a) (((a).tail-(a).head-1)&(a).mask)
+#define LAST(a) ((a).buf[(a).mask&((a).head-1)])
 #define FULL(a) (!LEFT(a))
-#define CHARS(a) (((a).head-(a).tail)&(TTY_BUF_SIZE-1))
+#define CHARS(a) (((a).head-(a).tail)&(a).mask)
 #define GETCH(queue,c) \
-(void)({c=(queue).buf[(queue).tail];INC((queue).tail);})
+(void)({c=(queue).buf[(queue).tail];INC((queue),(queue).tail);})
 #define PUTCH(c,queue) \
-(void)({(queue).buf[(queue).head]=(c);INC((queue).head);})
+(void)({(queue).buf[(queue).head]=(c);INC((queue),(queue).head);})
 
 #define INTR_CHAR(tty) ((tty)->termios.c_cc[VINTR])
 #define QUIT_CHAR(tty) ((tty)->termios.c_cc[VQUIT])
@@ -50,6 +82,7 @@ struct tty_struct {
 	struct tty_queue read_q;
 	struct tty_queue write_q;
 	struct tty_queue secondary;
+	struct tty_struct * link;	/* other side of a pty, or NULL */
 	};
 
 extern struct tty_struct tty_table[];
@@ -66,12 +99,30 @@ void rs_init(void);
 void con_init(void);
 void tty_init(void);
 
-int tty_read(unsigned c, char * buf, int n);
-int tty_write(unsigned c, char * buf, int n);
+int tty_read(unsigned c, char * buf, int n, int flags);
+int tty_write(unsigned c, char * buf, int n, int flags);
 
 void rs_write(struct tty_struct * tty);
 void con_write(struct tty_struct * tty);
 
+extern int fg_console;
+void change_console(unsigned int new_console);
+void scrollback(int lines);
+void scrollfront(int lines);
+
+void keymap_init(void);
+int get_keymap(struct kbd_keymap * map);
+int set_keymap(struct kbd_keymap * map);
+
 void copy_to_cooked(struct tty_struct * tty);
+void tty_intr(struct tty_struct * tty, int mask);
+struct tty_struct * get_tty(unsigned int minor);
+int tty_open(unsigned int minor);
+void tty_release(unsigned int minor);
+
+struct tty_struct * pty_tty(unsigned int minor);
+int pty_open(unsigned int minor);
+void pty_release(unsigned int minor);
+int tty_set_qsize(struct tty_queue * q, unsigned long size);
 
 #endif
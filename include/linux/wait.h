@@ -0,0 +1,19 @@
+#ifndef _WAIT_H
+#define _WAIT_H
+
+/*
+ * A wait queue is a NULL-terminated list of entries that live on the
+ * sleepers' own kernel stacks, so a head is just one pointer and needs
+ * no initialization. Exclusive sleepers are queued at the tail and only
+ * one of them is woken per wake_up(); the others all are.
+ */
+// 等待队列。队列项位于睡眠进程自己的内核栈上，队列头只是一个指针。
+// 非互斥等待者插在队首，每次wake_up()全部唤醒；互斥等待者排在队尾，
+// 每次只唤醒其中一个，避免"惊群"。
+struct wait_queue {
+	struct task_struct * task;
+	int exclusive;
+	struct wait_queue * next;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _POLL_H
+#define _POLL_H
+
+struct pollfd {
+	int fd;
+	short events;		/* what to wait for */
+	short revents;		/* what happened */
+};
+
+#define POLLIN		0x0001	/* data can be read */
+#define POLLPRI		0x0002	/* urgent data can be read */
+#define POLLOUT		0x0004	/* data can be written */
+#define POLLERR		0x0008	/* error (always reported) */
+#define POLLHUP		0x0010	/* the other end has gone (always reported) */
+#define POLLNVAL	0x0020	/* fd not open (always reported) */
+
+extern int poll(struct pollfd * fds, unsigned long nfds, int timeout);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _SCHED_H_USER
+#define _SCHED_H_USER
+
+/*
+ * Scheduling policies. SCHED_FIFO and SCHED_RR tasks always run before
+ * SCHED_OTHER ones, the highest sched_priority first. A FIFO task keeps
+ * the cpu until it blocks; RR tasks of equal priority take turns a time
+ * slice at a time.
+ */
+#define SCHED_OTHER	0
+#define SCHED_FIFO	1
+#define SCHED_RR	2
+
+#define SCHED_PRIO_MIN	1	/* real-time priorities, 0 for SCHED_OTHER */
+#define SCHED_PRIO_MAX	99
+
+struct sched_param {
+	int sched_priority;
+};
+
+extern int sched_setscheduler(int pid, int policy, const struct sched_param * param);
+extern int sched_getscheduler(int pid);
+extern int sched_getparam(int pid, struct sched_param * param);
+
+/*
+ * Fair-share groups. When a grouping is selected, cpu time is first
+ * divided between the groups in proportion to their weights, and only
+ * then between the tasks of each group by their priorities.
+ */
+#define SCHED_GROUP_NONE	0	/* every task for itself (the default) */
+#define SCHED_GROUP_SESSION	1	/* one group per session */
+#define SCHED_GROUP_PGRP	2	/* one group per process group */
+#define SCHED_GROUP_UID		3	/* one group per real uid */
+
+/* commands for sched_group() */
+#define SG_GETMODE	0	/* return the current grouping */
+#define SG_SETMODE	1	/* select grouping 'arg' (superuser only) */
+#define SG_GETWEIGHT	2	/* return the weight of group 'id' */
+#define SG_SETWEIGHT	3	/* set it to 'arg' (others: lower own group only) */
+
+#define SCHED_WEIGHT_DEF	20
+#define SCHED_WEIGHT_MAX	100
+
+extern int sched_group(int cmd, long id, int arg);
+
+#endif
@@ -33,8 +33,17 @@ typedef unsigned int sigset_t;		/* 32 bits */
 #define SIGTTIN		21
 #define SIGTTOU		22
 
+/*
+ * Real-time signals are queued: every kill() or sigqueue() is delivered
+ * once, with its value, in the order they were sent. Lower numbers go
+ * first, and all of them after the ordinary signals.
+ */
+#define SIGRTMIN	23
+#define SIGRTMAX	32
+
 /* Ok, I haven't implemented sigactions, but trying to keep headers POSIX */
 #define SA_NOCLDSTOP	1
+#define SA_SIGINFO	4	/* handler(sig, value), see below */
 #define SA_NOMASK	0x40000000
 #define SA_ONESHOT	0x80000000
 
@@ -52,6 +61,17 @@ struct sigaction {
 	void (*sa_restorer)(void);
 };
 
+/*
+ * A handler set with SA_SIGINFO is called as handler(sig, value), 0 for
+ * signals that carry no value. The value sits between the signal number
+ * and the rest of the frame, so such a handler needs one of the
+ * restorers below (the second one with SA_NOMASK) as its sa_restorer.
+ */
+union sigval {
+	int sival_int;
+	void * sival_ptr;
+};
+
 void (*signal(int _sig, void (*_func)(int)))(int);
 int raise(int sig);
 int kill(pid_t pid, int sig);
@@ -64,5 +84,8 @@ int sigpending(sigset_t *set);
 int sigprocmask(int how, sigset_t *set, sigset_t *oldset);
 int sigsuspend(sigset_t *sigmask);
 int sigaction(int sig, struct sigaction *act, struct sigaction *oldact);
+int sigqueue(pid_t pid, int sig, const union sigval value);
+void __siginfo_restore(void);
+void __siginfo_nomask_restore(void);
 
 #endif /* _SIGNAL_H */
@@ -0,0 +1,28 @@
+#ifndef _SYS_RESOURCE_H
+#define _SYS_RESOURCE_H
+
+/*
+ * Resource limits. Only RLIMIT_DATA (checked by brk) and RLIMIT_RSS
+ * (checked when a page is faulted in) are enforced by the kernel,
+ * the others are just kept for the user.
+ */
+#define RLIMIT_CPU	0	/* cpu time in seconds */
+#define RLIMIT_FSIZE	1	/* maximum filesize */
+#define RLIMIT_DATA	2	/* max data size */
+#define RLIMIT_STACK	3	/* max stack size */
+#define RLIMIT_CORE	4	/* max core file size */
+#define RLIMIT_RSS	5	/* max resident set size */
+
+#define RLIM_NLIMITS	6
+
+#define RLIM_INFINITY	0x7fffffff
+
+struct rlimit {
+	long rlim_cur;
+	long rlim_max;
+};
+
+extern int getrlimit(int resource, struct rlimit * rlp);
+extern int setrlimit(int resource, const struct rlimit * rlp);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _SYS_SYSTRACE_H
+#define _SYS_SYSTRACE_H
+
+/*
+ * System call tracing, controlled and read through systrace(). While it
+ * is on, every system call of the traced process (or of all of them)
+ * leaves a record in a kernel ring buffer and is added to per-call
+ * totals. Times are in timer clock cycles (1193180 per second).
+ */
+#define ST_OFF		0	/* stop tracing */
+#define ST_ON		1	/* trace pid 'arg', all processes if 0 */
+#define ST_READ		2	/* take up to 'arg' records into buf */
+#define ST_STATS	3	/* copy totals of calls 0..arg-1 into buf */
+#define ST_RESET	4	/* empty the buffer and clear the totals */
+
+#define ST_NR_CALLS	128	/* call numbers with totals kept */
+
+struct systrace_rec {
+	long pid;
+	long nr;		/* system call number */
+	long ret;		/* its return value */
+	unsigned long start;	/* entry time, low bits of the cycle count */
+	unsigned long lat;	/* entry-to-exit latency */
+};
+
+struct systrace_stat {
+	unsigned long count;
+	unsigned long total;	/* sum of the latencies */
+	unsigned long max;
+};
+
+extern int systrace(int cmd, long arg, void * buf);
+
+#endif
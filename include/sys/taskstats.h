@@ -0,0 +1,23 @@
+#ifndef _SYS_TASKSTATS_H
+#define _SYS_TASKSTATS_H
+
+/*
+ * Per-task scheduling and latency statistics, as returned by taskstats().
+ * All times are in clock ticks (HZ per second).
+ */
+struct taskstats {
+	long state;		/* 0 runnable, 1 interruptible, 2 uninterruptible ... */
+	long policy;		/* SCHED_OTHER, SCHED_FIFO or SCHED_RR */
+	long priority;		/* time slice (SCHED_OTHER) or real-time priority */
+	long utime, stime;	/* cpu time in user and kernel mode */
+	long wait_time;		/* runnable but waiting for the cpu */
+	long io_wait;		/* sleeping on block device I/O */
+	long nvcsw;		/* voluntary context switches (went to sleep) */
+	long nivcsw;		/* involuntary ones (preempted) */
+	long min_flt;		/* page faults served without disk I/O */
+	long maj_flt;		/* page faults that had to read the disk */
+};
+
+extern int taskstats(int pid, struct taskstats * buf);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef _SYS_TIME_H
+#define _SYS_TIME_H
+
+struct timeval {
+	long tv_sec;
+	long tv_usec;
+};
+
+/* one bit per file descriptor: NR_OPEN (20) fits in a long */
+#define FD_SETSIZE	32
+
+typedef struct fd_set {
+	unsigned long fds_bits[1];
+} fd_set;
+
+#define FD_SET(fd,fdsetp)	((fdsetp)->fds_bits[0] |= (1UL << (fd)))
+#define FD_CLR(fd,fdsetp)	((fdsetp)->fds_bits[0] &= ~(1UL << (fd)))
+#define FD_ISSET(fd,fdsetp)	(((fdsetp)->fds_bits[0] >> (fd)) & 1)
+#define FD_ZERO(fdsetp)		((fdsetp)->fds_bits[0] = 0)
+
+int select(int nfds, fd_set * readfds, fd_set * writefds,
+	fd_set * exceptfds, struct timeval * timeout);
+
+#endif
@@ -32,6 +32,35 @@
 #define TIOCGSOFTCAR	0x5419
 #define TIOCSSOFTCAR	0x541A
 #define TIOCINQ		0x541B
+#define TIOCGSERIAL	0x541E
+#define TIOCSSERIAL	0x541F
+#define TIOCGQSIZE	0x5420
+#define TIOCSQSIZE	0x5421
+#define TIOCGKEYMAP	0x5422
+#define TIOCSKEYMAP	0x5423
+
+/*
+ * queue sizes for TIOCGQSIZE/TIOCSQSIZE: powers of two, 1024 to 65536.
+ * Only the superuser may grow a queue beyond 1024.
+ */
+struct tty_qsize {
+	unsigned long read_q;
+	unsigned long write_q;
+	unsigned long secondary;
+};
+
+/*
+ * console keymap for TIOCGKEYMAP/TIOCSKEYMAP: the character each scan
+ * code gives, alone, with shift and with alt-gr. 0 means none. Ctrl,
+ * caps-lock and (left) alt are applied to these by the driver.
+ */
+#define NR_KEYS		128
+
+struct kbd_keymap {
+	unsigned char plain[NR_KEYS];
+	unsigned char shift[NR_KEYS];
+	unsigned char altgr[NR_KEYS];
+};
 
 struct winsize {
 	unsigned short ws_row;
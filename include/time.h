@@ -15,6 +15,11 @@ typedef unsigned int size_t;
 
 typedef long clock_t;
 
+struct timespec {
+	time_t tv_sec;
+	long tv_nsec;
+};
+
 struct tm {
 	int tm_sec;
 	int tm_min;
@@ -38,5 +43,6 @@ struct tm * gmtime(const time_t *tp);
 struct tm *localtime(const time_t * tp);
 size_t strftime(char * s, size_t smax, const char * fmt, const struct tm * tp);
 void tzset(void);
+int nanosleep(const struct timespec * rqtp, struct timespec * rmtp);
 
 #endif
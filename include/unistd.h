@@ -129,12 +129,37 @@
 #define __NR_ssetmask	69
 #define __NR_setreuid	70
 #define __NR_setregid	71
+#define __NR_getrlimit	72
+#define __NR_setrlimit	73
+#define __NR_nanosleep	74
+#define __NR_sched_group	75
+#define __NR_sched_setscheduler	76
+#define __NR_sched_getscheduler	77
+#define __NR_sched_getparam	78
+#define __NR_taskstats	79
+#define __NR_systrace	80
+#define __NR_poll	81
+#define __NR_select	82
+#define __NR_sigqueue	83
+
+/*
+ * Programs built with __USE_SYSENTER enter the kernel via sysenter: the
+ * stub leaves its %ebp and the return address on the user stack for the
+ * kernel to pick up. It needs a cpu with SEP: elsewhere sysenter is an
+ * invalid opcode, and the process is killed with SIGSEGV by die().
+ */
+#ifdef __USE_SYSENTER
+#define __syscall_insn \
+	"pushl %%ebp\n\tpushl $1f\n\tmovl %%esp,%%ebp\n\tsysenter\n1:"
+#else
+#define __syscall_insn "int $0x80"
+#endif
 
 #define _syscall0(type,name) \
 type name(void) \
 { \
 long __res; \
-__asm__ volatile ("int $0x80" \
+__asm__ volatile (__syscall_insn \
 	: "=a" (__res) \
 	: "0" (__NR_##name)); \
 if (__res >= 0) \
@@ -147,7 +172,7 @@ return -1; \
 type name(atype a) \
 { \
 long __res; \
-__asm__ volatile ("int $0x80" \
+__asm__ volatile (__syscall_insn \
 	: "=a" (__res) \
 	: "0" (__NR_##name),"b" ((long)(a))); \
 if (__res >= 0) \
@@ -160,7 +185,7 @@ return -1; \
 type name(atype a,btype b) \
 { \
 long __res; \
-__asm__ volatile ("int $0x80" \
+__asm__ volatile (__syscall_insn \
 	: "=a" (__res) \
 	: "0" (__NR_##name),"b" ((long)(a)),"c" ((long)(b))); \
 if (__res >= 0) \
@@ -173,7 +198,7 @@ return -1; \
 type name(atype a,btype b,ctype c) \
 { \
 long __res; \
-__asm__ volatile ("int $0x80" \
+__asm__ volatile (__syscall_insn \
 	: "=a" (__res) \
 	: "0" (__NR_##name),"b" ((long)(a)),"c" ((long)(b)),"d" ((long)(c))); \
 if (__res>=0) \
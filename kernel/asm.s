@@ -63,8 +63,14 @@ no_error_code:                  # 这里是无出错号处理的入口处。
 # int1 -- debug 调试中断入口点。处理过程同上。类型：错误/陷阱(Fault/Trap);错误号：无。
 # 当EFLAGS中TF标志置位时而引发的中断。当发现硬件断点(数据：陷阱，代码：错误)；或者
 # 开启了指令跟踪陷阱或任务交换陷阱，或者调试寄存器访问无效(错误)，CPU就会产生该异常。
+# sysenter不清TF：用户置TF后执行sysenter，第一条内核指令前就会产生单步陷阱，而此时
+# esp还指向sysenter_stack这个小栈。这种情况下不能再压栈，只清掉TF后返回。
 debug:
-	pushl $do_int3		# _do_debug C函数指针入栈
+	cmpl $sysenter_entry,(%esp)	# single step out of sysenter?
+	jne 1f
+	andl $0xfffffeff,8(%esp)	# then just clear TF
+	iret
+1:	pushl $do_int3		# _do_debug C函数指针入栈
 	jmp no_error_code
 
 # int2 - 非屏蔽中断调用入口点。类型：陷阱；无错误号。
@@ -27,7 +27,7 @@ struct request {
 	unsigned long sector;					// 起始扇区(1块=2扇区)
 	unsigned long nr_sectors;				// 读/写扇区数
 	char * buffer;							// 数据缓冲区
-	struct task_struct * waiting;			// 任务等待操作执行完成的地方
+	struct wait_queue * waiting;			// 任务等待操作执行完成的地方
 	struct buffer_head * bh;				// 缓冲区头指针
 	struct request * next;					// 指向下一请求项
 };
@@ -54,7 +54,7 @@ struct blk_dev_struct {
 
 extern struct blk_dev_struct blk_dev[NR_BLK_DEV];	// 块设备表(数组)，每种块设备占用一项
 extern struct request request[NR_REQUEST];			// 请求项队列数组
-extern struct task_struct * wait_for_request;		// 等待空闲请求项的进程队列头指针
+extern struct wait_queue * wait_for_request;		// 等待空闲请求项的进程队列头指针
 
 // 在块设备驱动程序(如hd.c)包含此头文件时，必须先定义驱动程序处理设备的主设备号
 // 这样下面就能为包含本文件的驱动程序给出正确的宏定义。
@@ -130,6 +130,7 @@ static inline void end_request(int uptodate)
 	}
 	wake_up(&CURRENT->waiting);				// 唤醒等待该请求项的进程
 	CURRENT->dev = -1;						// 释放该请求项
+	wake_up(&wait_for_request);				// 唤醒一个等待空闲请求项的进程
 	CURRENT = CURRENT->next;				// 从请求链表中删除该请求项，并且当前指针指向下一请求项目
 }
 
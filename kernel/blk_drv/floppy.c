@@ -102,7 +102,26 @@ static struct floppy_struct {
  */
 
 extern void floppy_interrupt(void);
-extern char tmp_floppy_area[1024];
+extern char tmp_floppy_area[18*2*512];
+
+/*
+ * The DMA controller only reaches the low 16Mb, and a transfer can't
+ * cross a 64kB boundary. Anything else goes through tmp_floppy_area.
+ */
+#define DMA_OK(addr,len) ((unsigned long)(addr)+(len) <= 0x1000000 && \
+	!((((unsigned long)(addr)) ^ ((unsigned long)(addr)+(len)-1)) & ~0xffff))
+
+/*
+ * Reads fetch a whole cylinder into tmp_floppy_area, and later reads
+ * from that cylinder are copied out of it without touching the drive.
+ * buffer_drive is -1 when there is nothing valid in the buffer (it's
+ * also used as a bounce buffer, and writes to the cylinder or a disk
+ * change invalidate it).
+ */
+static int buffer_drive = -1;
+static int buffer_track = -1;
+static struct floppy_struct * buffer_floppy = NULL;
+static int read_track = 0;
 
 /*
  * These are global variables, as that's the easiest way to give
@@ -120,7 +139,7 @@ static unsigned char seek_track = 0;
 static unsigned char current_track = 255;
 static unsigned char command = 0;
 unsigned char selected = 0;
-struct task_struct * wait_on_floppy_select = NULL;
+struct wait_queue * wait_on_floppy_select = NULL;
 
 void floppy_deselect(unsigned int nr)
 {
@@ -145,6 +164,8 @@ repeat:
 	if ((current_DOR & 3) != nr)
 		goto repeat;
 	if (inb(FD_DIR) & 0x80) {
+		if (buffer_drive == nr)
+			buffer_drive = -1;
 		floppy_off(nr);
 		return 1;
 	}
@@ -160,9 +181,15 @@ __asm__("cld ; rep ; movsl" \
 static void setup_DMA(void)
 {
 	long addr = (long) CURRENT->buffer;
+	long count = BLOCK_SIZE;
 
 	cli();
-	if (addr >= 0x100000) {
+	if (read_track) {
+		buffer_drive = -1;
+		addr = (long) tmp_floppy_area;
+		count = floppy->sect * floppy->head * 512;
+	} else if (!DMA_OK(addr,BLOCK_SIZE)) {
+		buffer_drive = -1;
 		addr = (long) tmp_floppy_area;
 		if (command == FD_WRITE)
 			copy_buffer(CURRENT->buffer,tmp_floppy_area);
@@ -180,12 +207,14 @@ static void setup_DMA(void)
 /* bits 8-15 of addr */
 	immoutb_p(addr,4);
 	addr >>= 8;
-/* bits 16-19 of addr */
+/* bits 16-23 of addr */
 	immoutb_p(addr,0x81);
+	count--;
 /* low 8 bits of count-1 (1024-1=0x3ff) */
-	immoutb_p(0xff,5);
+	immoutb_p(count,5);
+	count >>= 8;
 /* high 8 bits of count-1 */
-	immoutb_p(3,5);
+	immoutb_p(count,5);
 /* activate DMA 2 */
 	immoutb_p(0|2,10);
 	sti();
@@ -259,22 +288,36 @@ static void rw_interrupt(void)
 		do_fd_request();
 		return;
 	}
-	if (command == FD_READ && (unsigned long)(CURRENT->buffer) >= 0x100000)
+	if (read_track) {
+		buffer_drive = current_drive;
+		buffer_track = track;
+		buffer_floppy = floppy;
+		copy_buffer(tmp_floppy_area + 512 *
+			(CURRENT->sector % (floppy->sect * floppy->head)),
+			CURRENT->buffer);
+	} else if (command == FD_READ && !DMA_OK(CURRENT->buffer,BLOCK_SIZE))
 		copy_buffer(tmp_floppy_area,CURRENT->buffer);
 	floppy_deselect(current_drive);
 	end_request(1);
 	do_fd_request();
 }
 
-inline void setup_rw_floppy(void)
+static inline void setup_rw_floppy(void)
 {
 	setup_DMA();
 	do_floppy = rw_interrupt;
 	output_byte(command);
-	output_byte(head<<2 | current_drive);
-	output_byte(track);
-	output_byte(head);
-	output_byte(sector);
+	if (read_track) {	/* from head 0, sector 1: multi-track does the rest */
+		output_byte(current_drive);
+		output_byte(track);
+		output_byte(0);
+		output_byte(1);
+	} else {
+		output_byte(head<<2 | current_drive);
+		output_byte(track);
+		output_byte(head);
+		output_byte(sector);
+	}
 	output_byte(2);		/* sector size = 512 */
 	output_byte(floppy->sect);
 	output_byte(floppy->gap);
@@ -429,14 +472,23 @@ void do_fd_request(void)
 	}
 	INIT_REQUEST;
 	floppy = (MINOR(CURRENT->dev)>>2) + floppy_type;
-	if (current_drive != CURRENT_DEV)
-		seek = 1;
-	current_drive = CURRENT_DEV;
 	block = CURRENT->sector;
 	if (block+2 > floppy->size) {
 		end_request(0);
 		goto repeat;
 	}
+	if (CURRENT->cmd == READ && buffer_drive == CURRENT_DEV &&
+	    buffer_floppy == floppy &&
+	    buffer_track == block / (floppy->sect * floppy->head)) {
+		copy_buffer(tmp_floppy_area + 512 *
+			(block % (floppy->sect * floppy->head)),
+			CURRENT->buffer);
+		end_request(1);
+		goto repeat;
+	}
+	if (current_drive != CURRENT_DEV)
+		seek = 1;
+	current_drive = CURRENT_DEV;
 	sector = block % floppy->sect;
 	block /= floppy->sect;
 	head = block % floppy->head;
@@ -451,6 +503,11 @@ void do_fd_request(void)
 		command = FD_WRITE;
 	else
 		panic("do_fd_request: unknown command");
+/* retries after an error only read the block that was asked for */
+	read_track = (command == FD_READ && !CURRENT->errors);
+	if (command == FD_WRITE && buffer_drive == current_drive &&
+	    buffer_track == track)
+		buffer_drive = -1;
 	add_timer(ticks_to_floppy_on(current_drive),&floppy_on_interrupt);
 }
 
@@ -37,12 +37,27 @@ inb_p(0x71); \				// 0x71是读端口号
 
 // 重新矫正处理函数
 static void recal_intr(void);
+static void identify_drive(int drive);
 
 // 重新矫正标志。当设置了该标志，程序中会调用recal_intr()以将磁头移动到0柱面
 static int recalibrate = 1;
 // 复位标志。当发生读写错误时会设置标志并调用相关复位函数，以复位硬盘和控制器
 static int reset = 1;
 
+/*
+ * READ/WRITE MULTIPLE: mult_req[] is what IDENTIFY says the drive can
+ * take per interrupt, mult_count[] what it has actually been set to
+ * (0 means the old one-sector-per-interrupt commands). A reset loses
+ * the setting, so set_mult[] makes do_hd_request() issue it again.
+ */
+#define MAX_MULT	16
+static int mult_req[MAX_HD] = {0,};
+static int mult_count[MAX_HD] = {0,};
+static int set_mult[MAX_HD] = {0,};
+static int cur_mult = 1;		/* sectors per interrupt, current request */
+
+#define CHUNK(nr) ((nr) < cur_mult ? (nr) : cur_mult)
+
 /*
  *  This struct defines the HD's and their types.
  */
@@ -155,6 +170,8 @@ int sys_setup(void * BIOS)
 		hd[i*5].start_sect = 0;
 		hd[i*5].nr_sects = 0;
 	}
+	for (drive=0 ; drive<NR_HD ; drive++)
+		identify_drive(drive);
 	// NR_HD已确定，现在读取每个硬盘上第1个扇区中的分区表信息，用来设置分区
 	// 结构数组hd[]中硬盘各分区的信息。
 	for (drive=0 ; drive<NR_HD ; drive++) {
@@ -231,6 +248,42 @@ static void hd_out(unsigned int drive,unsigned int nsect,unsigned int sect,
 	outb(cmd,++port);
 }
 
+static void identify_intr(void)
+{
+}
+
+/*
+ * Ask the drive how many sectors it can move per interrupt. This is
+ * only done from sys_setup(), before any request is queued, so we
+ * simply poll. Old controllers abort IDENTIFY and stay single-sector.
+ */
+static void identify_drive(int drive)
+{
+	unsigned short * id;
+	int i, mult;
+
+	if (!(id = (unsigned short *) get_free_page()))
+		return;
+	hd_out(drive,0,0,0,0,WIN_IDENTIFY,&identify_intr);
+	for (i = 0 ; i < 100000 ; i++)
+		if (!(inb_p(HD_STATUS) & BUSY_STAT))
+			break;
+	if ((inb_p(HD_STATUS) & (BUSY_STAT|DRQ_STAT|ERR_STAT)) == DRQ_STAT) {
+		port_read(HD_DATA,id,256);
+		mult = id[47] & 0xff;
+		if (mult > MAX_MULT)
+			mult = MAX_MULT;
+		for (i = 1 ; i*2 <= mult ; i *= 2)
+			/* nothing */ ;
+		if (i > 1) {
+			mult_req[drive] = i;
+			printk("hd%d: %d sectors per interrupt\n\r",drive,i);
+		}
+	}
+	do_hd = NULL;
+	free_page((unsigned long) id);
+}
+
 // 等待磁盘就绪
 static int drive_busy(void)
 {
@@ -287,16 +340,19 @@ static void bad_rw_intr(void)
 // 读操作中断调用函数
 static void read_intr(void)
 {
+	int i;
+
 	if (win_result()) {
 		bad_rw_intr();
 		do_hd_request();
 		return;
 	}
-	port_read(HD_DATA,CURRENT->buffer,256);
+	i = CHUNK(CURRENT->nr_sectors);
+	port_read(HD_DATA,CURRENT->buffer,256*i);
 	CURRENT->errors = 0;
-	CURRENT->buffer += 512;
-	CURRENT->sector++;
-	if (--CURRENT->nr_sectors) {
+	CURRENT->buffer += 512*i;
+	CURRENT->sector += i;
+	if ((CURRENT->nr_sectors -= i)) {
 		do_hd = &read_intr;
 		return;
 	}
@@ -307,16 +363,19 @@ static void read_intr(void)
 // 写扇区中断调用函数
 static void write_intr(void)
 {
+	int i;
+
 	if (win_result()) {
 		bad_rw_intr();
 		do_hd_request();
 		return;
 	}
-	if (--CURRENT->nr_sectors) {
-		CURRENT->sector++;
-		CURRENT->buffer += 512;
+	i = CHUNK(CURRENT->nr_sectors);
+	if ((CURRENT->nr_sectors -= i)) {
+		CURRENT->sector += i;
+		CURRENT->buffer += 512*i;
 		do_hd = &write_intr;
-		port_write(HD_DATA,CURRENT->buffer,256);
+		port_write(HD_DATA,CURRENT->buffer,256*CHUNK(CURRENT->nr_sectors));
 		return;
 	}
 	end_request(1);
@@ -331,6 +390,16 @@ static void recal_intr(void)
 	do_hd_request();
 }
 
+static void setmult_intr(void)
+{
+	if (win_result()) {
+		printk("hd%d: can't set multiple mode\n\r",CURRENT_DEV);
+		mult_req[CURRENT_DEV] = 0;
+	} else
+		mult_count[CURRENT_DEV] = mult_req[CURRENT_DEV];
+	do_hd_request();
+}
+
 // 执行硬盘读写请求操作
 void do_hd_request(void)
 {
@@ -357,6 +426,11 @@ void do_hd_request(void)
 	if (reset) {
 		reset = 0;
 		recalibrate = 1;			// 置需重新校正标志
+		for (i = 0 ; i < NR_HD ; i++)
+			if (mult_req[i]) {
+				set_mult[i] = 1;
+				mult_count[i] = 0;
+			}
 		reset_hd(CURRENT_DEV);
 		return;
 	}
@@ -366,17 +440,25 @@ void do_hd_request(void)
 			WIN_RESTORE,&recal_intr);
 		return;
 	}	
+	if (set_mult[dev]) {
+		set_mult[dev] = 0;
+		hd_out(dev,mult_req[dev],0,0,0,WIN_SETMULT,&setmult_intr);
+		return;
+	}
+	cur_mult = mult_count[dev] ? mult_count[dev] : 1;
 	if (CURRENT->cmd == WRITE) {
-		hd_out(dev,nsect,sec,head,cyl,WIN_WRITE,&write_intr);
+		hd_out(dev,nsect,sec,head,cyl,
+			mult_count[dev] ? WIN_MULTWRITE : WIN_WRITE,&write_intr);
 		for(i=0 ; i<3000 && !(r=inb_p(HD_STATUS)&DRQ_STAT) ; i++)
 			/* nothing */ ;
 		if (!r) {
 			bad_rw_intr();
 			goto repeat;
 		}
-		port_write(HD_DATA,CURRENT->buffer,256);
+		port_write(HD_DATA,CURRENT->buffer,256*CHUNK(nsect));
 	} else if (CURRENT->cmd == READ) {
-		hd_out(dev,nsect,sec,head,cyl,WIN_READ,&read_intr);
+		hd_out(dev,nsect,sec,head,cyl,
+			mult_count[dev] ? WIN_MULTREAD : WIN_READ,&read_intr);
 	} else
 		panic("unknown hd-command");
 }
@@ -23,7 +23,7 @@ struct request request[NR_REQUEST];
 /*
  * 用于在请求数组没有空闲项时进程的临时等待处
  */
-struct task_struct * wait_for_request = NULL;
+struct wait_queue * wait_for_request = NULL;
 
 /* blk_dev_struct is:
  *	request_fn			// 对应主设备号的请求处理指针
@@ -46,11 +46,14 @@ struct blk_dev_struct blk_dev[NR_BLK_DEV] = {
 // 被执行解锁缓冲块的任务明确地唤醒
 static inline void lock_buffer(struct buffer_head * bh)
 {
+	long start = jiffies;
+
 	cli();						// 关中断
-	while (bh->b_lock)			// 如果缓冲区已被锁定则睡眠
-		sleep_on(&bh->b_wait);
+	while (bh->b_lock)			// 如果缓冲区已被锁定则睡眠（互斥等待，解锁时只唤醒一个）
+		sleep_on_exclusive(&bh->b_wait);
 	bh->b_lock=1;				// 立刻锁定该缓冲区
 	sti();						// 开中断
+	current->io_wait += jiffies - start;
 }
 
 // 解锁锁定的缓冲区
@@ -97,6 +100,7 @@ static void make_request(int major,int rw, struct buffer_head * bh)
 {
 	struct request * req;
 	int rw_ahead;			// 逻辑值，用于判断是否为READA或者WRITEA命令(预读/写)
+	long start;
 
 /* WRITEA/READA is special case - it is not really needed, so if the */
 /* buffer is locked, we just forget about it, else it's a normal read */
@@ -134,6 +138,7 @@ repeat:
 	// 从后往前搜索，当请求结构request的设备字段dev值=-1时，表示该项未被占用(空闲)。
 	// 如果没有一项是空闲的（此时请求项数组指针已经搜索越过头部），则查看此次请求是否
 	// 是预读/写，如果是则放弃此次请求操作。否则让本次请求操作先睡眠
+	cli();
 	if (rw == READ)
 		req = request+NR_REQUEST;
 	else
@@ -145,14 +150,19 @@ repeat:
 /* if none found, sleep on new requests: check for rw_ahead */
 	if (req < request) {
 		if (rw_ahead) {
+			sti();
 			unlock_buffer(bh);
 			return;
 		}
-		sleep_on(&wait_for_request);
+		start = jiffies;
+		sleep_on_exclusive(&wait_for_request);
+		current->io_wait += jiffies - start;
 		goto repeat;
 	}
+/* claim it before interrupts can hand it to anybody else */
+	req->dev = bh->b_dev;
+	sti();
 /* fill up the request-info, and add it to the queue */
-	req->dev = bh->b_dev;			// 设备号
 	req->cmd = rw;
 	req->errors=0;					// 操作时产生的错误次数
 	req->sector = bh->b_blocknr<<1;	// 起始扇区。块号转换成扇区号（1块=2扇区）
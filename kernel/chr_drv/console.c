@@ -12,6 +12,11 @@
  *	'void con_write(struct tty_queue * queue)'
  * Hopefully this will be a rather complete VT102 implementation.
  *
+ * Virtual consoles: video memory is split between up to NR_CONSOLES
+ * screens, each with its own state, so switching (alt-Fn) only moves
+ * the crtc origin. Lines scrolled off the top are kept in a history
+ * buffer per console that shift-PgUp/PgDn pages through.
+ *
  * Beeping thanks to John T Kohl.
  */
 
@@ -29,8 +34,10 @@
 
 #include <linux/sched.h>
 #include <linux/tty.h>
+#include <linux/mm.h>
 #include <asm/io.h>
 #include <asm/system.h>
+#include <string.h>
 
 /*
  * These are set up by the setup-routine at boot-time:
@@ -60,21 +67,72 @@ static unsigned long	video_num_columns;	/* Number of text columns	*/
 static unsigned long	video_size_row;		/* Bytes per row		*/
 static unsigned long	video_num_lines;	/* Number of test lines		*/
 static unsigned char	video_page;		/* Initial video page		*/
-static unsigned long	video_mem_start;	/* Start of video RAM		*/
-static unsigned long	video_mem_end;		/* End of video RAM (sort of)	*/
+static unsigned long	video_mem_base;		/* Start of video RAM		*/
+static unsigned long	video_mem_term;		/* End of video RAM (sort of)	*/
 static unsigned short	video_port_reg;		/* Video register select port	*/
 static unsigned short	video_port_val;		/* Video register value port	*/
 static unsigned short	video_erase_char;	/* Char+Attrib to erase with	*/
 
-static unsigned long	origin;		/* Used for EGA/VGA fast scroll	*/
-static unsigned long	scr_end;	/* Used for EGA/VGA fast scroll	*/
-static unsigned long	pos;
-static unsigned long	x,y;
-static unsigned long	top,bottom;
-static unsigned long	state=0;
-static unsigned long	npar,par[NPAR];
-static unsigned long	ques=0;
-static unsigned char	attr=0x07;
+static unsigned long	hw_origin;	/* origin/cursor as last written	*/
+static unsigned long	hw_cursor;	/* to the 6845, 0 = not yet		*/
+
+#define SB_ORDER	2		/* history block: 4 pages per console	*/
+
+/*
+ * Per-console state. 'vc' points to the console being worked on: it is
+ * set by con_write() and by the keyboard hooks, which save and restore
+ * it as they can interrupt a write.
+ */
+// 每个虚拟控制台的状态。vc指向当前正在操作的控制台，下面的宏使原来针对
+// 单个控制台的代码无需修改即可用于任一控制台。
+static struct vc_data {
+	unsigned long	vc_origin;	/* Used for EGA/VGA fast scroll	*/
+	unsigned long	vc_scr_end;	/* Used for EGA/VGA fast scroll	*/
+	unsigned long	vc_pos;
+	unsigned long	vc_x,vc_y;
+	unsigned long	vc_top,vc_bottom;
+	unsigned long	vc_state;
+	unsigned long	vc_npar,vc_par[NPAR];
+	unsigned long	vc_ques;
+	unsigned char	vc_attr;
+	int		vc_saved_x,vc_saved_y;
+	unsigned long	vc_video_mem_start;	/* this console's part	*/
+	unsigned long	vc_video_mem_end;	/* of video memory	*/
+	unsigned long	vc_sb_buf;	/* history, sb_lines rows	*/
+	unsigned long	vc_sb_save;	/* live screen while scrolled back */
+	unsigned long	vc_sb_head;	/* next history row to fill	*/
+	unsigned long	vc_sb_count;	/* rows in the history		*/
+	unsigned long	vc_sb_view;	/* rows scrolled back, 0 = live	*/
+} vc_cons[NR_CONSOLES];
+
+static struct vc_data * vc;
+static int nr_consoles;
+static unsigned long sb_lines;		/* history rows per console */
+int fg_console = 0;
+
+#define origin		(vc->vc_origin)
+#define scr_end		(vc->vc_scr_end)
+#define pos		(vc->vc_pos)
+#define x		(vc->vc_x)
+#define y		(vc->vc_y)
+#define top		(vc->vc_top)
+#define bottom		(vc->vc_bottom)
+#define state		(vc->vc_state)
+#define npar		(vc->vc_npar)
+#define par		(vc->vc_par)
+#define ques		(vc->vc_ques)
+#define attr		(vc->vc_attr)
+#define saved_x		(vc->vc_saved_x)
+#define saved_y		(vc->vc_saved_y)
+#define video_mem_start	(vc->vc_video_mem_start)
+#define video_mem_end	(vc->vc_video_mem_end)
+#define sb_buf		(vc->vc_sb_buf)
+#define sb_save		(vc->vc_sb_save)
+#define sb_head		(vc->vc_sb_head)
+#define sb_count	(vc->vc_sb_count)
+#define sb_view		(vc->vc_sb_view)
+
+#define FG_CONSOLE	(vc == vc_cons+fg_console)
 
 static void sysbeep(void);
 
@@ -100,35 +158,79 @@ static inline void gotoxy(unsigned int new_x,unsigned int new_y)
 	pos=origin + y*video_size_row + (x<<1);     // 1列用2个字节表示，x<<1.
 }
 
+/*
+ * The crtc is only reprogrammed when the value really changed: scrup()
+ * and con_write() just update origin/pos and call these once at the end
+ * of a write, so a screenful of output costs one register update.
+ */
+// 只有当显示起始位置确实改变时才写6845寄存器。滚屏时只修改origin，
+// 在一次con_write()结束时才调用本函数。
 static inline void set_origin(void)
 {
 	cli();
-	outb_p(12, video_port_reg);
-	outb_p(0xff&((origin-video_mem_start)>>9), video_port_val);
-	outb_p(13, video_port_reg);
-	outb_p(0xff&((origin-video_mem_start)>>1), video_port_val);
+	if (FG_CONSOLE && origin != hw_origin) {
+		hw_origin = origin;
+		outb_p(12, video_port_reg);
+		outb_p(0xff&((origin-video_mem_base)>>9), video_port_val);
+		outb_p(13, video_port_reg);
+		outb_p(0xff&((origin-video_mem_base)>>1), video_port_val);
+	}
 	sti();
 }
 
-static void scrup(void)
+/*
+ * Keep n rows starting at 'from' in the history buffer. Only the last
+ * sb_lines of them can matter.
+ */
+// 把从from开始的n行保存到本控制台的历史缓冲区(环形)中。
+static void sb_keep(unsigned long from, unsigned long n)
 {
+	if (!sb_buf)
+		return;
+	if (n > sb_lines) {
+		from += (n-sb_lines)*video_size_row;
+		n = sb_lines;
+	}
+	while (n--) {
+		memcpy((char *) sb_buf + sb_head*video_size_row,
+			(char *) from, video_size_row);
+		from += video_size_row;
+		if (++sb_head == sb_lines)
+			sb_head = 0;
+		if (sb_count < sb_lines)
+			sb_count++;
+	}
+}
+
+/*
+ * Scroll the region top..bottom up by n lines (1 <= n <= bottom-top),
+ * so that a run of line feeds costs a single copy. The new origin is
+ * handed to the crtc by con_write() when the write is done.
+ */
+// 把top..bottom区域向上滚动n行。连续的多个换行只需一次内存移动。
+// 从屏幕顶端滚出的行保存到历史缓冲区中。
+static void scrup(unsigned long n)
+{
+	if (!top)
+		sb_keep(origin,n);
 	if (video_type == VIDEO_TYPE_EGAC || video_type == VIDEO_TYPE_EGAM)
 	{
 		if (!top && bottom == video_num_lines) {
-			origin += video_size_row;
-			pos += video_size_row;
-			scr_end += video_size_row;
+			origin += n*video_size_row;
+			pos += n*video_size_row;
+			scr_end += n*video_size_row;
 			if (scr_end > video_mem_end) {
 				__asm__("cld\n\t"
 					"rep\n\t"
 					"movsl\n\t"
-					"movl video_num_columns,%1\n\t"
+					"movl %%edx,%%ecx\n\t"
 					"rep\n\t"
 					"stosw"
 					::"a" (video_erase_char),
-					"c" ((video_num_lines-1)*video_num_columns>>1),
+					"c" ((video_num_lines-n)*video_num_columns>>1),
 					"D" (video_mem_start),
-					"S" (origin)
+					"S" (origin),
+					"d" (n*video_num_columns)
 					);
 				scr_end -= origin-video_mem_start;
 				pos -= origin-video_mem_start;
@@ -138,22 +240,22 @@ static void scrup(void)
 					"rep\n\t"
 					"stosw"
 					::"a" (video_erase_char),
-					"c" (video_num_columns),
-					"D" (scr_end-video_size_row)
+					"c" (n*video_num_columns),
+					"D" (scr_end-n*video_size_row)
 					);
 			}
-			set_origin();
 		} else {
 			__asm__("cld\n\t"
 				"rep\n\t"
 				"movsl\n\t"
-				"movl video_num_columns,%%ecx\n\t"
+				"movl %%edx,%%ecx\n\t"
 				"rep\n\t"
 				"stosw"
 				::"a" (video_erase_char),
-				"c" ((bottom-top-1)*video_num_columns>>1),
+				"c" ((bottom-top-n)*video_num_columns>>1),
 				"D" (origin+video_size_row*top),
-				"S" (origin+video_size_row*(top+1))
+				"S" (origin+video_size_row*(top+n)),
+				"d" (n*video_num_columns)
 				);
 		}
 	}
@@ -162,13 +264,14 @@ static void scrup(void)
 		__asm__("cld\n\t"
 			"rep\n\t"
 			"movsl\n\t"
-			"movl video_num_columns,%%ecx\n\t"
+			"movl %%edx,%%ecx\n\t"
 			"rep\n\t"
 			"stosw"
 			::"a" (video_erase_char),
-			"c" ((bottom-top-1)*video_num_columns>>1),
+			"c" ((bottom-top-n)*video_num_columns>>1),
 			"D" (origin+video_size_row*top),
-			"S" (origin+video_size_row*(top+1))
+			"S" (origin+video_size_row*(top+n)),
+			"d" (n*video_num_columns)
 			);
 	}
 }
@@ -207,14 +310,30 @@ static void scrdown(void)
 	}
 }
 
-static void lf(void)
+/*
+ * Move down n lines, scrolling whatever doesn't fit in one go.
+ */
+// 光标下移n行。超出滚动区域底部的部分用一次scrup()完成。
+static void lf_n(unsigned long n)
 {
-	if (y+1<bottom) {
-		y++;
-		pos += video_size_row;
+	if (y+n<bottom) {
+		y += n;
+		pos += n*video_size_row;
 		return;
 	}
-	scrup();
+	if (y+1<bottom) {
+		n -= bottom-1-y;
+		pos += (bottom-1-y)*video_size_row;
+		y = bottom-1;
+	}
+	if (n > bottom-top)
+		n = bottom-top;
+	scrup(n);
+}
+
+static void lf(void)
+{
+	lf_n(1);
 }
 
 static void ri(void)
@@ -242,12 +361,12 @@ static void del(void)
 	}
 }
 
-static void csi_J(int par)
+static void csi_J(int vpar)
 {
 	long count;
 	long start;
 
-	switch (par) {
+	switch (vpar) {
 		case 0:	/* erase from cursor to end of display */
 			count = (scr_end-pos)>>1;
 			start = pos;
@@ -271,12 +390,12 @@ static void csi_J(int par)
 		);
 }
 
-static void csi_K(int par)
+static void csi_K(int vpar)
 {
 	long count;
 	long start;
 
-	switch (par) {
+	switch (vpar) {
 		case 0:	/* erase from cursor to end of line */
 			if (x>=video_num_columns)
 				return;
@@ -319,10 +438,13 @@ void csi_m(void)
 static inline void set_cursor(void)
 {
 	cli();
-	outb_p(14, video_port_reg);
-	outb_p(0xff&((pos-video_mem_start)>>9), video_port_val);
-	outb_p(15, video_port_reg);
-	outb_p(0xff&((pos-video_mem_start)>>1), video_port_val);
+	if (FG_CONSOLE && pos != hw_cursor) {
+		hw_cursor = pos;
+		outb_p(14, video_port_reg);
+		outb_p(0xff&((pos-video_mem_base)>>9), video_port_val);
+		outb_p(15, video_port_reg);
+		outb_p(0xff&((pos-video_mem_base)>>1), video_port_val);
+	}
 	sti();
 }
 
@@ -389,7 +511,7 @@ static void delete_line(void)
 	oldbottom=bottom;
 	top=y;
 	bottom = video_num_lines;
-	scrup();
+	scrup(1);
 	top=oldtop;
 	bottom=oldbottom;
 }
@@ -434,9 +556,6 @@ static void csi_M(unsigned int nr)
 		delete_line();
 }
 
-static int saved_x=0;
-static int saved_y=0;
-
 static void save_cur(void)
 {
 	saved_x=x;
@@ -448,11 +567,170 @@ static void restore_cur(void)
 	gotoxy(saved_x, saved_y);
 }
 
+/*
+ * Scrollback. While a console is scrolled back its live screen is kept
+ * in sb_save and video memory shows history rows followed by the top
+ * of the saved screen. Any output to the console brings it back.
+ */
+// 显示向回滚动sb_view行后的画面：前面是历史行，后面是保存的屏幕内容。
+static void sb_show(void)
+{
+	unsigned long r, l;
+	char * from;
+
+	for (r = 0 ; r < video_num_lines ; r++) {
+		if (r >= sb_view)
+			from = (char *) sb_save + (r-sb_view)*video_size_row;
+		else {
+			l = sb_head + sb_lines - sb_view + r;
+			if (l >= sb_lines)
+				l -= sb_lines;
+			from = (char *) sb_buf + l*video_size_row;
+		}
+		memcpy((char *) origin + r*video_size_row, from, video_size_row);
+	}
+}
+
+// 回到实时画面：恢复保存的屏幕内容。
+static void sb_unview(void)
+{
+	memcpy((char *) origin, (char *) sb_save,
+		video_num_lines*video_size_row);
+	sb_view = 0;
+}
+
+/*
+ * shift-PgUp/PgDn, called from the keyboard interrupt. 'lines' 0 means
+ * half a screen. A console that is being written to stays live.
+ */
+// 前台控制台向回/向前滚动lines行(0表示半屏)。由键盘中断调用。
+void scrollback(int lines)
+{
+	struct vc_data * old = vc;
+
+	if (FG_CONSOLE)
+		return;
+	vc = vc_cons + fg_console;
+	if (sb_buf && sb_count) {
+		if (!lines)
+			lines = video_num_lines/2;
+		if (!sb_view)
+			memcpy((char *) sb_save, (char *) origin,
+				video_num_lines*video_size_row);
+		sb_view += lines;
+		if (sb_view > sb_count)
+			sb_view = sb_count;
+		sb_show();
+	}
+	vc = old;
+}
+
+void scrollfront(int lines)
+{
+	struct vc_data * old = vc;
+
+	if (FG_CONSOLE)
+		return;
+	vc = vc_cons + fg_console;
+	if (sb_view) {
+		if (!lines)
+			lines = video_num_lines/2;
+		if (lines >= sb_view)
+			sb_unview();
+		else {
+			sb_view -= lines;
+			sb_show();
+		}
+	}
+	vc = old;
+}
+
+/*
+ * alt-Fn: bring another console to the front. Its screen is already in
+ * video memory, so this only moves the crtc origin and cursor.
+ */
+// 切换前台控制台。各控制台的画面都在显示内存中，只需修改6845的显示起始位置和光标。
+void change_console(unsigned int new_console)
+{
+	extern struct tty_queue * table_list[];
+	struct vc_data * old = vc;
+
+	if (new_console == fg_console || new_console >= nr_consoles)
+		return;
+	fg_console = new_console;
+	table_list[0] = &tty_table[CON_MINOR(new_console)].read_q;
+	table_list[1] = &tty_table[CON_MINOR(new_console)].write_q;
+	vc = vc_cons + new_console;
+	set_origin();
+	set_cursor();
+	vc = old;
+}
+
+/*
+ * Put a run of printable characters from the write queue straight into
+ * video memory, up to the end of the line. Returns how many were taken.
+ */
+// 把写队列中连续的可显示字符直接写入显示内存，直到行尾或遇到控制字符为止。
+// 返回取走的字符数。
+static int put_run(struct tty_queue * q, int nr)
+{
+	unsigned short * p = (unsigned short *) pos;
+	unsigned short a = attr << 8;
+	unsigned char c;
+	int n = 0;
+
+	while (n < nr && x < video_num_columns) {
+		c = q->buf[q->tail];
+		if (c < 32 || c > 126)
+			break;
+		*p++ = a | c;
+		INC(*q,q->tail);
+		x++;
+		n++;
+	}
+	pos = (unsigned long) p;
+	return n;
+}
+
+/*
+ * Count a run of line feeds (and the carriage returns mixed in with
+ * them) so that they can be done with one scroll. Returns the number of
+ * line feeds; *crp is set if a carriage return was seen.
+ */
+// 统计写队列中连续的换行符(中间可夹有回车符)，以便一次滚屏完成。
+static int lf_run(struct tty_queue * q, int * nrp, int * crp)
+{
+	unsigned char c;
+	int n = 0;
+
+	while (*nrp) {
+		c = q->buf[q->tail];
+		if (c == 13)
+			*crp = 1;
+		else if (c == 10 || c == 11 || c == 12)
+			n++;
+		else
+			break;
+		INC(*q,q->tail);
+		(*nrp)--;
+	}
+	return n;
+}
+
 void con_write(struct tty_struct * tty)
 {
-	int nr;
+	int nr, cr_seen;
 	char c;
+	struct vc_data * old = vc;
+	unsigned int n = MINOR_CON(tty - tty_table);
 
+	if (n >= nr_consoles) {		/* no video memory left for it */
+		tty->write_q.tail = tty->write_q.head;
+		return;
+	}
+	vc = vc_cons + n;
+	if (sb_view)
+		sb_unview();
 	nr = CHARS(tty->write_q);
 	while (nr--) {
 		GETCH(tty->write_q,c);
@@ -464,17 +742,22 @@ void con_write(struct tty_struct * tty)
 						pos -= video_size_row;
 						lf();
 					}
-					__asm__("movb attr,%%ah\n\t"
+					__asm__("movb %2,%%ah\n\t"
 						"movw %%ax,%1\n\t"
-						::"a" (c),"m" (*(short *)pos)
+						::"a" (c),"m" (*(short *)pos),
+						"m" (attr)
 						);
 					pos += 2;
 					x++;
+					nr -= put_run(&tty->write_q,nr);
 				} else if (c==27)
 					state=1;
-				else if (c==10 || c==11 || c==12)
-					lf();
-				else if (c==13)
+				else if (c==10 || c==11 || c==12) {
+					cr_seen = 0;
+					lf_n(1+lf_run(&tty->write_q,&nr,&cr_seen));
+					if (cr_seen)
+						cr();
+				} else if (c==13)
 					cr();
 				else if (c==ERASE_CHAR(tty))
 					del();
@@ -607,7 +890,9 @@ void con_write(struct tty_struct * tty)
 				}
 		}
 	}
+	set_origin();
 	set_cursor();
+	vc = old;
 }
 
 /*
@@ -633,6 +918,8 @@ void con_init(void)
 	register unsigned char a;
 	char *display_desc = "????";
 	char *display_ptr;
+	unsigned long screen_size, video_memory;
+	int i;
 
     // 首先根据setup.s程序取得系统硬件参数初始化几个本函数专用的静态全局变量。
 	video_num_columns = ORIG_VIDEO_COLS;    // 显示器显示字符列数
@@ -645,7 +932,7 @@ void con_init(void)
     // 索引端口号和显示寄存器数据端口号。如果原始显示模式等于7，则表示是单色显示器。
 	if (ORIG_VIDEO_MODE == 7)			/* Is this a monochrome display? */
 	{
-		video_mem_start = 0xb0000;      // 设置单显映象内存起始地址
+		video_mem_base = 0xb0000;       // 设置单显映象内存起始地址
 		video_port_reg = 0x3b4;         // 设置单显索引寄存器端口
 		video_port_val = 0x3b5;         // 设置单显数据寄存器端口
         // 接着我们根据BIOS中断int 0x10 功能0x12获得的显示模式信息，判断显示卡是
@@ -661,13 +948,13 @@ void con_init(void)
 		if ((ORIG_VIDEO_EGA_BX & 0xff) != 0x10)
 		{
 			video_type = VIDEO_TYPE_EGAM;       // 设置显示类型(EGA单色)
-			video_mem_end = 0xb8000;            // 设置显示内存末端地址
+			video_mem_term = 0xb8000;           // 设置显示内存末端地址
 			display_desc = "EGAm";              // 设置显示描述字符串
 		}
 		else    // 如果 BX 寄存器的值等于 0x10，则说明是单色显示卡MDA。
 		{
 			video_type = VIDEO_TYPE_MDA;        // 设置显示类型(MDA单色)
-			video_mem_end	= 0xb2000;          // 设置显示内存末端地址
+			video_mem_term	= 0xb2000;          // 设置显示内存末端地址
 			display_desc = "*MDA";              // 设置显示描述字符串
 		}
 	}
@@ -675,21 +962,21 @@ void con_init(void)
     // 显示控制索引寄存器端口地址为 0x3d4；数据寄存器端口地址为 0x3d5。
 	else								/* If not, it is color. */
 	{
-		video_mem_start = 0xb8000;              // 显示内存起始地址
+		video_mem_base = 0xb8000;               // 显示内存起始地址
 		video_port_reg	= 0x3d4;                // 设置彩色显示索引寄存器端口
 		video_port_val	= 0x3d5;                // 设置彩色显示数据寄存器端口
-        // 再判断显示卡类别。如果 BX 不等于 0x10，则说明是EGA/VGA 显示卡。此时实际上我们
-        // 可以使用32KB显示内存(0xb8000 -- 0xc0000),但该程序只使用了其中16KB显示内存。
+        // 再判断显示卡类别。如果 BX 不等于 0x10，则说明是EGA/VGA 显示卡。此时可以使用
+        // 32KB显示内存(0xb8000 -- 0xc0000)，由各虚拟控制台分用。
 		if ((ORIG_VIDEO_EGA_BX & 0xff) != 0x10)
 		{
 			video_type = VIDEO_TYPE_EGAC;       // 设置显示类型(EGA彩色)
-			video_mem_end = 0xbc000;            // 设置显示内存末端地址
+			video_mem_term = 0xc0000;           // 设置显示内存末端地址
 			display_desc = "EGAc";              // 设置显示描述字符串
 		}
 		else    // 如果 BX 寄存器的值等于 0x10,则说明是CGA显示卡，只使用8KB显示内存
 		{
 			video_type = VIDEO_TYPE_CGA;        // 设置显示类型(CGA彩色)
-			video_mem_end = 0xba000;            // 设置显示内存末端地址
+			video_mem_term = 0xba000;           // 设置显示内存末端地址
 			display_desc = "*CGA";              // 设置显示描述字符串
 		}
 	}
@@ -699,7 +986,7 @@ void con_init(void)
     // 然后我们在屏幕的右上角显示描述字符串。采用的方法是直接将字符串写到显示内存
     // 相应位置处。首先将显示指针display_ptr 指到屏幕第1行右端差4个字符处(每个字符
     // 需2个字节，因此减8)，然后循环复制字符串的字符，并且每复制1个字符都空开1个属性字节。
-	display_ptr = ((char *)video_mem_start) + video_size_row - 8;
+	display_ptr = ((char *)video_mem_base) + video_size_row - 8;
 	while (*display_desc)
 	{
 		*display_ptr++ = *display_desc++;
@@ -708,15 +995,41 @@ void con_init(void)
 	
 	/* Initialize the variables used for scrolling (mostly EGA/VGA)	*/
 	
-	origin	= video_mem_start;              // 滚屏起始显示内存地址
-	scr_end	= video_mem_start + video_num_lines * video_size_row;   // 结束地址
-	top	= 0;                                // 最顶行号
-	bottom	= video_num_lines;              // 最底行号
+    // 显示内存能容纳几屏就设几个虚拟控制台(最多NR_CONSOLES个)，每个控制台分得其中
+    // 一段，并分配一块历史缓冲区，其末尾用来在向回滚动时保存当前屏幕。
+	screen_size = video_num_lines * video_size_row;
+	nr_consoles = (video_mem_term - video_mem_base) / screen_size;
+	if (nr_consoles > NR_CONSOLES)
+		nr_consoles = NR_CONSOLES;
+	if (!nr_consoles)
+		nr_consoles = 1;
+	video_memory = ((video_mem_term - video_mem_base) / nr_consoles) & ~1;
+	sb_lines = ((PAGE_SIZE<<SB_ORDER) - screen_size) / video_size_row;
+	for (i = 0 ; i < nr_consoles ; i++) {
+		vc = vc_cons + i;
+		video_mem_start = video_mem_base + i*video_memory;
+		video_mem_end = video_mem_start + video_memory;
+		origin	= video_mem_start;              // 滚屏起始显示内存地址
+		scr_end	= video_mem_start + screen_size;    // 结束地址
+		top	= 0;                                // 最顶行号
+		bottom	= video_num_lines;              // 最底行号
+		attr	= 0x07;
+		if ((sb_buf = get_free_pages(SB_ORDER)))
+			sb_save = sb_buf + sb_lines*video_size_row;
+		if (i) {
+			gotoxy(0,0);
+			csi_J(2);
+		}
+	}
+	hw_origin = video_mem_base;
 
     // 最后初始化当前光标所在位置和光标对应的内存位置pos，并设置键盘中断0x21陷阱门
     // 描述符，&keyboard_interrupt是键盘中断处理过程地址。取消8259A中对键盘中断的
     // 屏蔽，允许响应键盘发出的IRQ1请求信号。最后复位键盘控制器以允许键盘开始正常工作。
+	vc = vc_cons;
 	gotoxy(ORIG_X,ORIG_Y);
+	vc = NULL;
+	keymap_init();
 	set_trap_gate(0x21,&keyboard_interrupt);
 	outb_p(inb_p(0x21)&0xfd,0x21);          // 取消对键盘中断的屏蔽，允许IRQ1。
 	a=inb_p(0x61);                          // 读取键盘端口0x61(8255A端口PB)
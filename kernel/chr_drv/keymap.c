@@ -0,0 +1,118 @@
+/*
+ *  linux/kernel/chr_drv/keymap.c
+ *
+ *  (C) 1991  Linus Torvalds
+ */
+
+/*
+ * Keyboard translation tables. Instead of working out shift, alt-gr,
+ * ctrl and caps-lock for every key, keyboard.S picks one of the tables
+ * in kbd_xlate by kbd_mode_index[mode] and looks the scan code up in it.
+ * The tables are built from the maps in 'keymap', which start out as the
+ * layout compiled into keyboard.S and can be replaced with TIOCSKEYMAP.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <termios.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/tty.h>
+
+#include <asm/segment.h>
+#include <asm/system.h>
+
+#define KBD_MAP_SIZE	0x61	/* size of the maps in keyboard.S */
+
+/* bits of a translation table number */
+#define XL_CTRL		1
+#define XL_CAPS		2
+#define XL_SHIFT	4
+#define XL_ALTGR	8
+#define NR_XLATE	16
+
+extern unsigned char key_map[], shift_map[], alt_map[];
+
+static struct kbd_keymap keymap;
+
+unsigned char kbd_xlate[NR_XLATE][NR_KEYS];
+unsigned char kbd_mode_index[256];
+
+// 计算字符c在编号为which的转换表中的结果，规则与原来keyboard.S中do_self的
+// 处理相同：ctrl或caps-lock把小写字母转为大写，ctrl再把64-95转为控制字符。
+static unsigned char xlate(unsigned char c, int which)
+{
+	if (!c)
+		return 0;
+	if ((which & (XL_CTRL|XL_CAPS)) && c >= 'a' && c <= '}')
+		c -= 32;
+	if ((which & XL_CTRL) && c >= 64 && c < 64+32)
+		c -= 64;
+	return c;
+}
+
+static void build_xlate(void)
+{
+	unsigned char * map;
+	int i, k;
+
+	for (i = 0 ; i < NR_XLATE ; i++) {
+		if (i & XL_ALTGR)
+			map = keymap.altgr;
+		else if (i & XL_SHIFT)
+			map = keymap.shift;
+		else
+			map = keymap.plain;
+		for (k = 0 ; k < NR_KEYS ; k++)
+			kbd_xlate[i][k] = xlate(map[k],i);
+	}
+}
+
+// 初始化：取keyboard.S中编译进来的键盘布局，并建立各转换表和mode到表号的索引。
+// mode各位见keyboard.S：0x03 shift，0x0c ctrl，0x20 alt-gr，0x40 caps-lock。
+void keymap_init(void)
+{
+	int m, i;
+
+	for (i = 0 ; i < KBD_MAP_SIZE ; i++) {
+		keymap.plain[i] = key_map[i];
+		keymap.shift[i] = shift_map[i];
+		keymap.altgr[i] = alt_map[i];
+	}
+	for (m = 0 ; m < 256 ; m++)
+		kbd_mode_index[m] = ((m & 0x0c) ? XL_CTRL : 0) |
+			((m & 0x40) ? XL_CAPS : 0) |
+			((m & 0x03) ? XL_SHIFT : 0) |
+			((m & 0x20) ? XL_ALTGR : 0);
+	build_xlate();
+}
+
+int get_keymap(struct kbd_keymap * map)
+{
+	char * p = (char *) &keymap;
+	int i;
+
+	verify_area(map, sizeof (*map));
+	for (i = 0 ; i < sizeof (*map) ; i++)
+		put_fs_byte(p[i],i + (char *) map);
+	return 0;
+}
+
+/* the keyboard interrupt uses the tables, so they are rebuilt under cli */
+int set_keymap(struct kbd_keymap * map)
+{
+	struct kbd_keymap tmp;
+	char * p = (char *) &tmp;
+	int i;
+
+	if (!suser())
+		return -EPERM;
+	for (i = 0 ; i < sizeof (*map) ; i++)
+		p[i] = get_fs_byte(i + (char *) map);
+	cli();
+	memcpy(&keymap,&tmp,sizeof (tmp));
+	build_xlate();
+	sti();
+	return 0;
+}
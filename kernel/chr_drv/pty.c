@@ -0,0 +1,257 @@
+/*
+ *  linux/kernel/chr_drv/pty.c
+ *
+ *  (C) 1991  Linus Torvalds
+ */
+
+/*
+ * Pseudo terminals. A pty is a pair of ttys with nothing behind them:
+ * what is written to one side is put in the read queue of the other and
+ * goes through the usual copy_to_cooked(). The slave behaves like the
+ * console, the master is raw. Pairs are allocated when the master is
+ * opened, so only the pointers in pty_table cost memory when unused.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stddef.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/tty.h>
+#include <linux/mm.h>
+
+#include <asm/system.h>
+
+#define HUPMASK (1<<(SIGHUP-1))
+
+#define PTY_ORDER	1	/* two pages hold a pair */
+
+struct pty_struct {
+	struct tty_struct master;
+	struct tty_struct slave;
+	int count[2];		/* opens of the master and of the slave */
+	int busy;		/* pty_write() is moving chars */
+};
+
+static struct pty_struct * pty_table[NR_PTYS];
+
+static struct termios master_termios = {
+	0,
+	0,
+	B9600 | CS8,
+	0,
+	0,
+	INIT_C_CC
+};
+
+static struct termios slave_termios = {
+	ICRNL,
+	OPOST|ONLCR,
+	0,
+	ISIG | ICANON | ECHO | ECHOCTL | ECHOKE,
+	0,
+	INIT_C_CC
+};
+
+/*
+ * Move what has been written on one side to the read queue of the other,
+ * as much as it has room for. Returns the number of chars moved.
+ */
+// 把from写队列中的字符移到另一侧的读队列中并加工，另一侧已关闭时丢弃输出。
+// 返回移过去的字符数。
+static int pty_move(struct tty_struct * from)
+{
+	struct tty_struct * to = from->link;
+	int n = 0;
+	char c;
+
+	if (!to) {
+		from->write_q.tail = from->write_q.head;
+		wake_up(&from->write_q.proc_list);
+		return 0;
+	}
+	while (!from->stopped && !EMPTY(from->write_q)) {
+		if (FULL(to->read_q)) {
+			if (FULL(to->secondary))
+				break;
+			copy_to_cooked(to);
+			continue;
+		}
+		GETCH(from->write_q,c);
+		PUTCH(c,to->read_q);
+		n++;
+	}
+	copy_to_cooked(to);
+	wake_up(&from->write_q.proc_list);
+	return n;
+}
+
+/*
+ * The write routine of both sides. copy_to_cooked() echoes by calling the
+ * write routine of the side it cooks for, so with ECHO on both sides the
+ * two would call each other for ever. Instead a nested call just leaves
+ * the chars queued, and the outer one goes round again until nothing
+ * moves: echo needs room in secondary, so that ends. The reader calls the
+ * write routine again when it has made room (see tty_read()).
+ */
+// 伪终端两侧共用的写函数。回显会再调用另一侧的写函数，两侧都开着ECHO时会无限递归，
+// 所以嵌套调用只把字符留在队列里，由最外层循环搬运，直到两侧都没有字符可移为止。
+static void pty_write(struct pty_struct * pty)
+{
+	if (pty->busy)
+		return;
+	pty->busy = 1;
+	while (pty_move(&pty->master) + pty_move(&pty->slave))
+		/* nothing */ ;
+	pty->busy = 0;
+}
+
+static void master_write(struct tty_struct * tty)
+{
+	pty_write((struct pty_struct *) ((char *) tty -
+		offsetof(struct pty_struct,master)));
+}
+
+static void slave_write(struct tty_struct * tty)
+{
+	pty_write((struct pty_struct *) ((char *) tty -
+		offsetof(struct pty_struct,slave)));
+}
+
+/* a queue in a freshly allocated pair: get_free_pages() doesn't clear */
+static void new_queue(struct tty_queue * q)
+{
+	q->proc_list = NULL;
+	q->buf = q->init_buf;
+	q->mask = TTY_BUF_SIZE-1;
+	q->busy = 0;
+}
+
+/* buf stays: tty_set_qsize() can't take it away while it is busy */
+static void init_queue(struct tty_queue * q)
+{
+	q->data = q->head = q->tail = 0;
+}
+
+/*
+ * Give back queues grown with TIOCSQSIZE; what is left in them goes.
+ * A queue somebody is still copying out of keeps its buffer for now.
+ */
+static void shrink_queue(struct tty_queue * q)
+{
+	q->tail = q->head;
+	tty_set_qsize(q,TTY_BUF_SIZE);
+}
+
+static void shrink_queues(struct tty_struct * tty)
+{
+	shrink_queue(&tty->read_q);
+	shrink_queue(&tty->write_q);
+	shrink_queue(&tty->secondary);
+}
+
+/* wait queues are left alone: a pair is only reused with no opens */
+static void init_tty(struct tty_struct * tty, struct termios * termios,
+	void (*write)(struct tty_struct * tty), struct tty_struct * link)
+{
+	tty->termios = *termios;
+	tty->pgrp = 0;
+	tty->stopped = 0;
+	tty->write = write;
+	init_queue(&tty->read_q);
+	init_queue(&tty->write_q);
+	init_queue(&tty->secondary);
+	tty->link = link;
+}
+
+struct tty_struct * pty_tty(unsigned int minor)
+{
+	struct pty_struct * pty;
+
+	if (minor >= PTY_SLAVE)
+		return (pty = pty_table[minor-PTY_SLAVE]) ? &pty->slave : NULL;
+	return (pty = pty_table[minor-PTY_MASTER]) ? &pty->master : NULL;
+}
+
+// 打开伪终端。主设备一次只能被打开一次(打开失败说明该对正在使用，可以试下一个)，
+// 打开时分配这一对终端的结构；从设备要在主设备打开后才能打开。
+int pty_open(unsigned int minor)
+{
+	struct pty_struct * pty;
+	int n;
+
+	if (minor >= PTY_SLAVE) {
+		pty = pty_table[minor-PTY_SLAVE];
+		if (!pty || !pty->count[0])
+			return -EIO;
+		pty->count[1]++;
+		pty->master.link = &pty->slave;	/* cut by the last close */
+		return 0;
+	}
+	n = minor-PTY_MASTER;
+	if ((pty = pty_table[n])) {
+		if (pty->count[0] || pty->count[1])
+			return -EIO;
+		shrink_queues(&pty->master);
+		shrink_queues(&pty->slave);
+	} else {
+		if (!(pty = (struct pty_struct *) get_free_pages(PTY_ORDER)))
+			return -ENOMEM;
+		new_queue(&pty->master.read_q);
+		new_queue(&pty->master.write_q);
+		new_queue(&pty->master.secondary);
+		new_queue(&pty->slave.read_q);
+		new_queue(&pty->slave.write_q);
+		new_queue(&pty->slave.secondary);
+		pty->count[1] = 0;
+		pty->busy = 0;
+		pty_table[n] = pty;
+	}
+	init_tty(&pty->master,&master_termios,master_write,&pty->slave);
+	init_tty(&pty->slave,&slave_termios,slave_write,&pty->master);
+	pty->count[0] = 1;
+	return 0;
+}
+
+/* also counts a reader asleep in a fault in read_raw() */
+static int sleepers(struct tty_struct * tty)
+{
+	return tty->read_q.proc_list || tty->write_q.proc_list ||
+		tty->secondary.proc_list || tty->secondary.busy;
+}
+
+/*
+ * Last close of one side. When the master goes the slave is hung up.
+ * The pair is freed once both sides are closed, unless someone still
+ * sleeps on it (through /dev/tty), in which case the next open of the
+ * master reuses it.
+ */
+// 关闭伪终端的一侧。主设备关闭时向从设备的进程组发SIGHUP，并唤醒在其上等待的进程。
+void pty_release(unsigned int minor)
+{
+	struct pty_struct * pty;
+	int n, side;
+
+	side = (minor >= PTY_SLAVE);
+	n = minor - (side ? PTY_SLAVE : PTY_MASTER);
+	if (!(pty = pty_table[n]) || !pty->count[side])
+		return;
+	if (--pty->count[side])
+		return;
+	if (!side) {
+		pty->slave.link = NULL;
+		tty_intr(&pty->slave,HUPMASK);
+		wake_up(&pty->slave.secondary.proc_list);
+		wake_up(&pty->slave.write_q.proc_list);
+	} else
+		pty->master.link = NULL;
+	if (pty->count[0] || pty->count[1])
+		return;
+	if (sleepers(&pty->master) || sleepers(&pty->slave))
+		return;
+	shrink_queues(&pty->master);
+	shrink_queues(&pty->slave);
+	pty_table[n] = NULL;
+	free_pages((unsigned long) pty,PTY_ORDER);
+}
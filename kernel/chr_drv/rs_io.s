@@ -13,19 +13,21 @@
 .text
 .globl rs1_interrupt,rs2_interrupt
 
-size	= 1024				/* must be power of two !
-					   and must match the value
-					   in tty_io.c!!! */
-
 /* these are the offsets into the read/write buffer structures */
 rs_addr = 0
 head = 4
 tail = 8
 proc_list = 12
-buf = 16
+buf = 16			/* pointer to the buffer */
+mask = 20			/* its size-1 */
 
 startup	= 256		/* chars left in write queue when we restart it */
 
+/* offsets into struct rs_info (linux/serial.h), 5 longs per line */
+xmit_fifo = 0
+overrun = 4
+dropped = 8
+
 /*
  * These are the actual interrupt routines. They look where
  * the interrupt is coming from, and take appropriate action.
@@ -57,6 +59,7 @@ rep_int:
 	inb %dx,%al
 	testb $1,%al
 	jne end
+	andb $7,%al		/* fifo bits off, rx timeout (0xc) -> read_char */
 	cmpb $6,%al		/* this shouldn't happen, but ... */
 	ja end
 	movl 24(%esp),%ecx
@@ -67,6 +70,9 @@ rep_int:
 	jmp rep_int
 end:	movb $0x20,%al
 	outb %al,$0x20		/* EOI */
+	pushl 32(%esp)		/* old cs */
+	call preempt_check	/* switch now if we woke a real-time task */
+	addl $4,%esp
 	pop %ds
 	pop %es
 	popl %eax
@@ -89,55 +95,114 @@ modem_status:
 line_status:
 	addl $5,%edx		/* clear intr by reading line status reg. */
 	inb %dx,%al
+	testb $2,%al		/* overrun error? */
+	je 1f
+	call rs_line		# %ebx = rs_info offset of this line
+	incl rs_info+overrun(%ebx)
+1:	ret
+
+/*
+ * %ecx points into table_list: return the offset of the line's rs_info
+ * entry in %ebx.
+ */
+.align 2
+rs_line:
+	movl %ecx,%ebx
+	subl $table_list,%ebx
+	shrl $3,%ebx			# tty line
+	leal (%ebx,%ebx,4),%ebx
+	shll $2,%ebx			# * sizeof(struct rs_info)
 	ret
 
+/*
+ * Empty the receive fifo: keep reading while the line status says data
+ * is ready, then let do_tty_interrupt handle the whole batch at once.
+ */
 .align 2
 read_char:
-	inb %dx,%al
-	movl %ecx,%edx
-	subl $table_list,%edx
-	shrl $3,%edx
+	movl %ecx,%eax
+	subl $table_list,%eax
+	shrl $3,%eax
+	pushl %eax			# tty line
+	call rs_line
+	pushl %ebx			# rs_info offset
+	pushl %edx			# data port
 	movl (%ecx),%ecx		# read-queue
+1:	inb %dx,%al
 	movl head(%ecx),%ebx
-	movb %al,buf(%ecx,%ebx)
+	movl buf(%ecx),%edx
+	movb %al,(%edx,%ebx)
 	incl %ebx
-	andl $size-1,%ebx
+	andl mask(%ecx),%ebx
 	cmpl tail(%ecx),%ebx
-	je 1f
+	je 2f
 	movl %ebx,head(%ecx)
-1:	pushl %edx
-	call do_tty_interrupt
+	jmp 3f
+2:	movl 4(%esp),%ebx
+	incl rs_info+dropped(%ebx)	# read queue full
+3:	movl (%esp),%edx
+	addl $5,%edx			# line status reg.
+	inb %dx,%al
+	testb $2,%al			# overrun error?
+	je 4f
+	movl 4(%esp),%ebx
+	incl rs_info+overrun(%ebx)
+4:	movl (%esp),%edx
+	testb $1,%al			# more data ready?
+	jne 1b
+	addl $8,%esp
+	call do_tty_interrupt		# the line is left on the stack
 	addl $4,%esp
 	ret
 
+/*
+ * The transmitter is empty: refill it with up to xmit_fifo chars (16
+ * for a 16550A, 1 otherwise).
+ */
 .align 2
 write_char:
+	call rs_line
+	pushl rs_info+xmit_fifo(%ebx)	# chars left to send this time
 	movl 4(%ecx),%ecx		# write-queue
 	movl head(%ecx),%ebx
 	subl tail(%ecx),%ebx
-	andl $size-1,%ebx		# nr chars in queue
-	je write_buffer_empty
+	andl mask(%ecx),%ebx		# nr chars in queue
+	je 2f
 	cmpl $startup,%ebx
 	ja 1f
-	movl proc_list(%ecx),%ebx	# wake up sleeping process
-	testl %ebx,%ebx			# is there any?
-	je 1f
-	movl $0,(%ebx)
+	pushl %edx
+	pushl %ecx
+	leal proc_list(%ecx),%eax
+	pushl %eax
+	call wake_up			# wake up sleeping processes
+	addl $4,%esp
+	popl %ecx
+	popl %edx
 1:	movl tail(%ecx),%ebx
-	movb buf(%ecx,%ebx),%al
+	movl buf(%ecx),%eax
+	movb (%eax,%ebx),%al
 	outb %al,%dx
 	incl %ebx
-	andl $size-1,%ebx
+	andl mask(%ecx),%ebx
 	movl %ebx,tail(%ecx)
 	cmpl head(%ecx),%ebx
-	je write_buffer_empty
+	je 2f
+	decl (%esp)
+	jne 1b
+	addl $4,%esp
 	ret
+2:	addl $4,%esp
+	jmp write_buffer_empty
 .align 2
 write_buffer_empty:
-	movl proc_list(%ecx),%ebx	# wake up sleeping process
-	testl %ebx,%ebx			# is there any?
-	je 1f
-	movl $0,(%ebx)
+	pushl %edx
+	pushl %ecx
+	leal proc_list(%ecx),%eax
+	pushl %eax
+	call wake_up			# wake up sleeping processes
+	addl $4,%esp
+	popl %ecx
+	popl %edx
 1:	incl %edx
 	inb %dx,%al
 	jmp 1f
@@ -13,13 +13,47 @@
  * and all interrupts pertaining to serial IO.
  */
 
+#include <errno.h>
+
 #include <linux/tty.h>
 #include <linux/sched.h>
+#include <linux/kernel.h>
+#include <linux/serial.h>
 #include <asm/system.h>
 #include <asm/io.h>
+#include <asm/segment.h>
 
 #define WAKEUP_CHARS (TTY_BUF_SIZE/4)
 
+/*
+ * Default receive fifo trigger level. Lower means more interrupts,
+ * higher leaves less room before the 16 byte fifo overruns.
+ */
+#define RS_TRIGGER 8
+
+struct rs_info rs_info[3];		/* line 0 is the console */
+
+// 接收FIFO触发级别对应的FIFO控制寄存器位(位7-6)。
+static unsigned char fcr_trigger(int level)
+{
+	if (level >= 14)
+		return 0xc0;
+	if (level >= 8)
+		return 0x80;
+	if (level >= 4)
+		return 0x40;
+	return 0x00;
+}
+
+// 设置FIFO控制寄存器：允许FIFO并设置接收触发级别，其他类型的芯片关闭FIFO。
+static void set_fifo(int port, struct rs_info * info)
+{
+	if (info->type == PORT_16550A)
+		outb_p(0x01 | fcr_trigger(info->rx_trigger),port+2);
+	else
+		outb_p(0x00,port+2);
+}
+
 extern void rs1_interrupt(void);
 extern void rs2_interrupt(void);
 
@@ -27,7 +61,9 @@ extern void rs2_interrupt(void);
 // 设置指定串行端口的传输波特率(2400bps)并允许除了写保持寄存器空以为的所有中断源。
 // 另外，在输出2字节的波特率因子时，须首先设置线路控制寄存器DLAB位(位7).
 // 参数：port是串行端口基地址，串口1 - 0x3F8; 串口2 - 0x2F8
-static void init(int port)
+// 然后检测16550A：允许FIFO后读中断标识寄存器，位7-6均为1说明FIFO可用。16550的FIFO
+// 有缺陷，与8250/16450一样每次中断只收发一个字符。
+static void init(int port, struct rs_info * info)
 {
     // 设置线路控制寄存器的DLAB位(位7)
 	outb_p(0x80,port+3);	/* set DLAB of line control reg */
@@ -39,6 +75,22 @@ static void init(int port)
 	outb_p(0x03,port+3);	/* reset DLAB */
     // 设置DTR,RTS,辅助用户输出2
 	outb_p(0x0b,port+4);	/* set DTR,RTS, OUT_2 */
+	outb_p(0x07,port+2);	/* try to enable and clear the fifos */
+	switch (inb_p(port+2) & 0xc0) {
+		case 0xc0:
+			info->type = PORT_16550A;
+			info->xmit_fifo = 16;
+			break;
+		case 0x80:
+			info->type = PORT_16550;
+			info->xmit_fifo = 1;
+			break;
+		default:
+			info->type = PORT_16450;
+			info->xmit_fifo = 1;
+	}
+	info->rx_trigger = RS_TRIGGER;
+	set_fifo(port,info);
     // 除了写(写保持空)以外，允许所有中断源中断
 	outb_p(0x0d,port+1);	/* enable all intrs but writes */
     // 读数据口，以进行复位操作(?)
@@ -53,8 +105,8 @@ void rs_init(void)
     // 串口1使用的中断是int 0x24，串口2的是int 0x23.
 	set_intr_gate(0x24,rs1_interrupt);      // 设置串行口1的中断门向量(IRQ4信号)
 	set_intr_gate(0x23,rs2_interrupt);      // 设置串行口2的中断门向量(IRQ3信号)
-	init(tty_table[1].read_q.data);         // 初始化串行口1(.data是端口基地址)
-	init(tty_table[2].read_q.data);         // 初始化串行口2
+	init(tty_table[1].read_q.data,rs_info+1);	// 初始化串行口1(.data是端口基地址)
+	init(tty_table[2].read_q.data,rs_info+2);	// 初始化串行口2
 	outb(inb_p(0x21)&0xE7,0x21);            // 允许主8259A响应IRQ3、IRQ4中断请求
 }
 
@@ -72,3 +124,35 @@ void rs_write(struct tty_struct * tty)
 		outb(inb_p(tty->write_q.data+1)|0x02,tty->write_q.data+1);
 	sti();
 }
+
+// 取串行线路line的类型、FIFO设置和丢失字符计数(ioctl TIOCGSERIAL)。
+int rs_get_serial(int line, struct serial_struct * ss)
+{
+	struct rs_info * info = rs_info + line;
+
+	verify_area(ss,sizeof(*ss));
+	put_fs_long(info->type,(unsigned long *) &ss->type);
+	put_fs_long(info->xmit_fifo,(unsigned long *) &ss->xmit_fifo_size);
+	put_fs_long(info->rx_trigger,(unsigned long *) &ss->rx_trigger);
+	put_fs_long(info->overrun,&ss->overrun);
+	put_fs_long(info->dropped,&ss->dropped);
+	return 0;
+}
+
+// 设置串行线路line的接收FIFO触发级别(ioctl TIOCSSERIAL)。
+int rs_set_serial(int line, struct serial_struct * ss)
+{
+	struct rs_info * info = rs_info + line;
+	int level;
+
+	if (!suser())
+		return -EPERM;
+	level = get_fs_long((unsigned long *) &ss->rx_trigger);
+	if (level != 1 && level != 4 && level != 8 && level != 14)
+		return -EINVAL;
+	cli();
+	info->rx_trigger = level;
+	set_fifo(tty_table[line].read_q.data,info);
+	sti();
+	return 0;
+}
@@ -12,6 +12,7 @@
  */
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 
 #define ALRMMASK (1<<(SIGALRM-1))
@@ -20,8 +21,12 @@
 #define QUITMASK (1<<(SIGQUIT-1))
 #define TSTPMASK (1<<(SIGTSTP-1))
 
+#include <string.h>
+
 #include <linux/sched.h>
 #include <linux/tty.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
 #include <asm/segment.h>
 #include <asm/system.h>
 
@@ -42,13 +47,17 @@
 #define I_CRNL(tty)	_I_FLAG((tty),ICRNL)
 #define I_NOCR(tty)	_I_FLAG((tty),IGNCR)
 
+/* raw input: chars go from read_q to secondary and on to the reader as they are */
+#define RAW_INPUT(tty)	(!L_CANON(tty) && !L_ISIG(tty) && !L_ECHO(tty) && \
+	!_I_FLAG((tty),(IUCLC|INLCR|ICRNL|IGNCR)))
+
 #define O_POST(tty)	_O_FLAG((tty),OPOST)
 #define O_NLCR(tty)	_O_FLAG((tty),ONLCR)
 #define O_CRNL(tty)	_O_FLAG((tty),OCRNL)
 #define O_NLRET(tty)	_O_FLAG((tty),ONLRET)
 #define O_LCUC(tty)	_O_FLAG((tty),OLCUC)
 
-struct tty_struct tty_table[] = {
+struct tty_struct tty_table[NR_TTYS] = {
 	{
 		{ICRNL,		/* change incoming CR to NL */
 		OPOST|ONLCR,	/* change outgoing NL to CRNL */
@@ -94,7 +103,8 @@ struct tty_struct tty_table[] = {
 /*
  * these are the tables used by the machine code handlers.
  * you can implement pseudo-tty's or something by changing
- * them. Currently not done.
+ * them. Currently not done. The first pair is the keyboard's,
+ * change_console() points it at the foreground console.
  */
 struct tty_queue * table_list[]={
 	&tty_table[0].read_q, &tty_table[0].write_q,
@@ -106,20 +116,63 @@ struct tty_queue * table_list[]={
 // 初始化串口终端和控制台终端
 void tty_init(void)
 {
+	struct tty_struct * tty;
+	int i;
+
+    // 其他虚拟控制台与第一个控制台的设置相同。
+	for (i = 1 ; i < NR_CONSOLES ; i++) {
+		tty = tty_table + CON_MINOR(i);
+		tty->termios = tty_table[0].termios;
+		tty->write = con_write;
+	}
+    // 各队列先使用结构中自带的默认大小缓冲区。
+	for (tty = tty_table ; tty < tty_table+NR_TTYS ; tty++) {
+		tty->read_q.buf = tty->read_q.init_buf;
+		tty->write_q.buf = tty->write_q.init_buf;
+		tty->secondary.buf = tty->secondary.init_buf;
+		tty->read_q.mask = tty->write_q.mask =
+			tty->secondary.mask = TTY_BUF_SIZE-1;
+	}
     // 初始化串行中断程序和串行接口1和2（serial.c）
 	rs_init();
 	con_init();     // 初始化控制台终端(console.c文件中)
 }
 
+/* the tty of a minor, NULL if there is none (a pty that isn't open) */
+struct tty_struct * get_tty(unsigned int minor)
+{
+	if (minor < NR_TTYS)
+		return tty_table + minor;
+	if (IS_PTY(minor))
+		return pty_tty(minor);
+	return NULL;
+}
+
+// 打开/关闭(最后一次)终端设备文件时由fs/open.c调用。只有伪终端需要处理。
+int tty_open(unsigned int minor)
+{
+	if (minor < NR_TTYS)
+		return 0;
+	if (IS_PTY(minor))
+		return pty_open(minor);
+	return -ENXIO;
+}
+
+void tty_release(unsigned int minor)
+{
+	if (IS_PTY(minor))
+		pty_release(minor);
+}
+
 void tty_intr(struct tty_struct * tty, int mask)
 {
-	int i;
+	struct task_struct * p;
 
 	if (tty->pgrp <= 0)
 		return;
-	for (i=0;i<NR_TASKS;i++)
-		if (task[i] && task[i]->pgrp==tty->pgrp)
-			task[i]->signal |= mask;
+	for_each_task(p)
+		if (p->pgrp==tty->pgrp)
+			p->signal |= mask;
 }
 
 static void sleep_if_empty(struct tty_queue * queue)
@@ -145,10 +198,106 @@ void wait_for_keypress(void)
 	sleep_if_empty(&tty_table[0].secondary);
 }
 
+/*
+ * Raw fast paths: move the chars in contiguous runs instead of one by
+ * one. copy_raw() moves as much of queue 'from' as fits into 'to',
+ * read_raw() up to nr chars of q to user space.
+ */
+static void copy_raw(struct tty_queue * from, struct tty_queue * to)
+{
+	unsigned long n;
+
+	while ((n = CHARS(*from)) && LEFT(*to)) {
+		if (n > LEFT(*to))
+			n = LEFT(*to);
+		if (n > QSIZE(*from) - from->tail)
+			n = QSIZE(*from) - from->tail;
+		if (n > QSIZE(*to) - to->head)
+			n = QSIZE(*to) - to->head;
+		memcpy(to->buf + to->head, from->buf + from->tail, n);
+		from->tail = (from->tail + n) & from->mask;
+		to->head = (to->head + n) & to->mask;
+	}
+}
+
+static int read_raw(struct tty_queue * q, char * buf, int nr)
+{
+	char * b = buf;
+	unsigned long n;
+
+	while (nr > 0 && (n = CHARS(*q))) {
+		if (n > nr)
+			n = nr;
+		if (n > QSIZE(*q) - q->tail)
+			n = QSIZE(*q) - q->tail;
+		q->busy++;		/* memcpy_tofs() may sleep in a fault */
+		memcpy_tofs(b, q->buf + q->tail, n);
+		q->tail = (q->tail + n) & q->mask;
+		q->busy--;
+		b += n;
+		nr -= n;
+	}
+	return b - buf;
+}
+
+static int qorder(unsigned long size)
+{
+	int order = 0;
+
+	while ((PAGE_SIZE << order) < size)
+		order++;
+	return order;
+}
+
+/*
+ * Give queue q a buffer of 'size' chars, a power of two from
+ * TTY_BUF_SIZE (the queue's own init_buf) to TTY_BUF_MAX (pages from
+ * get_free_pages()). What the queue holds is kept, as far as it fits.
+ * Not while a reader is copying out of the old buffer: -EBUSY then.
+ */
+int tty_set_qsize(struct tty_queue * q, unsigned long size)
+{
+	char * buf, * old;
+	unsigned long n, old_size;
+
+	if (size < TTY_BUF_SIZE || size > TTY_BUF_MAX || (size & (size-1)))
+		return -EINVAL;
+	if (size == QSIZE(*q))
+		return 0;
+	if (size == TTY_BUF_SIZE)
+		buf = q->init_buf;
+	else if (!(buf = (char *) get_free_pages(qorder(size))))
+		return -ENOMEM;
+	cli();
+	if (q->busy) {
+		sti();
+		if (buf != q->init_buf)
+			free_pages((unsigned long) buf,qorder(size));
+		return -EBUSY;
+	}
+	old = q->buf;
+	old_size = QSIZE(*q);
+	for (n = 0 ; n < size-1 && !EMPTY(*q) ; n++)
+		GETCH(*q,buf[n]);
+	q->buf = buf;
+	q->mask = size-1;
+	q->tail = 0;
+	q->head = n;
+	sti();
+	if (old != q->init_buf)
+		free_pages((unsigned long) old,qorder(old_size));
+	return 0;
+}
+
 void copy_to_cooked(struct tty_struct * tty)
 {
 	signed char c;
 
+	if (RAW_INPUT(tty)) {
+		copy_raw(&tty->read_q,&tty->secondary);
+		wake_up(&tty->secondary.proc_list);
+		return;
+	}
 	while (!EMPTY(tty->read_q) && !FULL(tty->secondary)) {
 		GETCH(tty->read_q,c);
 		if (c==13)
@@ -173,7 +322,7 @@ void copy_to_cooked(struct tty_struct * tty)
 						PUTCH(127,tty->write_q);
 						tty->write(tty);
 					}
-					DEC(tty->secondary.head);
+					DEC(tty->secondary,tty->secondary.head);
 				}
 				continue;
 			}
@@ -188,7 +337,7 @@ void copy_to_cooked(struct tty_struct * tty)
 					PUTCH(127,tty->write_q);
 					tty->write(tty);
 				}
-				DEC(tty->secondary.head);
+				DEC(tty->secondary,tty->secondary.head);
 				continue;
 			}
 			if (c==STOP_CHAR(tty)) {
@@ -230,15 +379,14 @@ void copy_to_cooked(struct tty_struct * tty)
 	wake_up(&tty->secondary.proc_list);
 }
 
-int tty_read(unsigned channel, char * buf, int nr)
+int tty_read(unsigned channel, char * buf, int nr, int flags)
 {
 	struct tty_struct * tty;
 	char c, * b=buf;
-	int minimum,time,flag=0;
+	int minimum,time,flag=0,n,again=0;
 	long oldalarm;
 
-	if (channel>2 || nr<0) return -1;
-	tty = &tty_table[channel];
+	if (!(tty = get_tty(channel)) || nr<0) return -1;
 	oldalarm = current->alarm;
 	time = 10L*tty->termios.c_cc[VTIME];
 	minimum = tty->termios.c_cc[VMIN];
@@ -258,10 +406,23 @@ int tty_read(unsigned channel, char * buf, int nr)
 			break;
 		if (EMPTY(tty->secondary) || (L_CANON(tty) &&
 		!tty->secondary.data && LEFT(tty->secondary)>20)) {
+			if (flags & O_NONBLOCK) {
+				again = 1;
+				break;
+			}
 			sleep_if_empty(&tty->secondary);
 			continue;
 		}
-		do {
+		if (!L_CANON(tty)) {
+			n = read_raw(&tty->secondary,b,nr);
+			b += n;
+			nr -= n;
+			if (EMPTY(tty->secondary) && !EMPTY(tty->read_q)) {
+				cli();		/* interrupts call it too */
+				copy_to_cooked(tty);
+				sti();
+			}
+		} else do {
 			GETCH(tty->secondary,c);
 			if (c==EOF_CHAR(tty) || c==10)
 				tty->secondary.data--;
@@ -273,6 +434,8 @@ int tty_read(unsigned channel, char * buf, int nr)
 					break;
 			}
 		} while (nr>0 && !EMPTY(tty->secondary));
+		if (tty->link)		/* pty: room for what the other side wrote */
+			tty->link->write(tty->link);
 		if (time && !L_CANON(tty)) {
 			if ((flag=(!oldalarm || time+jiffies<oldalarm)))
 				current->alarm = time+jiffies;
@@ -288,18 +451,40 @@ int tty_read(unsigned channel, char * buf, int nr)
 	current->alarm = oldalarm;
 	if (current->signal && !(b-buf))
 		return -EINTR;
+	if (again && !(b-buf))
+		return -EAGAIN;
 	return (b-buf);
 }
 
-int tty_write(unsigned channel, char * buf, int nr)
+// 终端的poll函数。可读的条件与tty_read()不必睡眠的条件相同：规范模式下要有完整的
+// 一行(或secondary队列快满了)。写队列不满即可写。
+int tty_poll(unsigned channel, int events, struct poll_table * table)
+{
+	struct tty_struct * tty;
+	int mask = 0;
+
+	if (!(tty = get_tty(channel)))
+		return POLLNVAL;
+	poll_wait(&tty->secondary.proc_list,table);
+	poll_wait(&tty->write_q.proc_list,table);
+	if (!EMPTY(tty->secondary) && !(L_CANON(tty) &&
+	    !tty->secondary.data && LEFT(tty->secondary)>20))
+		mask |= POLLIN;
+	if (!FULL(tty->write_q))
+		mask |= POLLOUT;
+	return mask & events;
+}
+
+int tty_write(unsigned channel, char * buf, int nr, int flags)
 {
 	static int cr_flag=0;
 	struct tty_struct * tty;
 	char c, *b=buf;
 
-	if (channel>2 || nr<0) return -1;
-	tty = channel + tty_table;
+	if (!(tty = get_tty(channel)) || nr<0) return -1;
 	while (nr>0) {
+		if ((flags & O_NONBLOCK) && FULL(tty->write_q))
+			break;
 		sleep_if_full(&tty->write_q);
 		if (current->signal)
 			break;
@@ -323,9 +508,14 @@ int tty_write(unsigned channel, char * buf, int nr)
 			PUTCH(c,tty->write_q);
 		}
 		tty->write(tty);
-		if (nr>0)
+		if (nr>0) {
+			if (flags & O_NONBLOCK)
+				break;
 			schedule();
+		}
 	}
+	if (nr>0 && !(b-buf) && !current->signal)
+		return -EAGAIN;
 	return (b-buf);
 }
 
@@ -10,6 +10,7 @@
 #include <linux/sched.h>
 #include <linux/kernel.h>
 #include <linux/tty.h>
+#include <linux/serial.h>
 
 #include <asm/io.h>
 #include <asm/segment.h>
@@ -53,6 +54,74 @@ static void send_break(struct tty_struct * tty)
 	/* do nothing - not implemented */
 }
 
+/*
+ * The raw fast paths in tty_io.c don't keep secondary.data (the number
+ * of complete lines) up to date, so recount it when the mode changes.
+ */
+static void count_lines(struct tty_struct * tty)
+{
+	unsigned long i;
+	char c;
+
+	cli();
+	tty->secondary.data = 0;
+	for (i = tty->secondary.tail ; i != tty->secondary.head ;
+	     i = (i+1) & tty->secondary.mask) {
+		c = tty->secondary.buf[i];
+		if (c == 10 || c == EOF_CHAR(tty))
+			tty->secondary.data++;
+	}
+	sti();
+}
+
+static int get_qsize(struct tty_struct * tty, struct tty_qsize * qs)
+{
+	verify_area(qs, sizeof (*qs));
+	put_fs_long(QSIZE(tty->read_q),&qs->read_q);
+	put_fs_long(QSIZE(tty->write_q),&qs->write_q);
+	put_fs_long(QSIZE(tty->secondary),&qs->secondary);
+	return 0;
+}
+
+/*
+ * Queues above TTY_BUF_SIZE are pages of kernel memory, so only the
+ * superuser may grow them there. Shrinking is always allowed.
+ */
+// 检查队列q能否改为size大小(0表示不变)。
+static int check_qsize(struct tty_queue * q, unsigned long size)
+{
+	if (!size)
+		return 0;
+	if (size < TTY_BUF_SIZE || size > TTY_BUF_MAX || (size & (size-1)))
+		return -EINVAL;
+	if (size > TTY_BUF_SIZE && size > QSIZE(*q) && !suser())
+		return -EPERM;
+	return 0;
+}
+
+/* a size of 0 leaves that queue alone. All three are checked first */
+static int set_qsize(struct tty_struct * tty, struct tty_qsize * qs)
+{
+	unsigned long r, w, s;
+	int error;
+
+	r = get_fs_long(&qs->read_q);
+	w = get_fs_long(&qs->write_q);
+	s = get_fs_long(&qs->secondary);
+	if ((error = check_qsize(&tty->read_q,r)) ||
+	    (error = check_qsize(&tty->write_q,w)) ||
+	    (error = check_qsize(&tty->secondary,s)))
+		return error;
+	if (r && (error = tty_set_qsize(&tty->read_q,r)))
+		return error;
+	if (w && (error = tty_set_qsize(&tty->write_q,w)))
+		return error;
+	if (s && (error = tty_set_qsize(&tty->secondary,s)))
+		return error;
+	count_lines(tty);
+	return 0;
+}
+
 static int get_termios(struct tty_struct * tty, struct termios * termios)
 {
 	int i;
@@ -70,6 +139,7 @@ static int set_termios(struct tty_struct * tty, struct termios * termios)
 	for (i=0 ; i< (sizeof (*termios)) ; i++)
 		((char *)&tty->termios)[i]=get_fs_byte(i+(char *)termios);
 	change_speed(tty);
+	count_lines(tty);
 	return 0;
 }
 
@@ -109,6 +179,7 @@ static int set_termio(struct tty_struct * tty, struct termio * termio)
 	for(i=0 ; i < NCC ; i++)
 		tty->termios.c_cc[i] = tmp_termio.c_cc[i];
 	change_speed(tty);
+	count_lines(tty);
 	return 0;
 }
 
@@ -121,7 +192,8 @@ int tty_ioctl(int dev, int cmd, int arg)
 			panic("tty_ioctl: dev<0");
 	} else
 		dev=MINOR(dev);
-	tty = dev + tty_table;
+	if (!(tty = get_tty(dev)))
+		return -EIO;
 	switch (cmd) {
 		case TCGETS:
 			return get_termios(tty,(struct termios *) arg);
@@ -198,6 +270,28 @@ int tty_ioctl(int dev, int cmd, int arg)
 			return -EINVAL; /* not implemented */
 		case TIOCSSOFTCAR:
 			return -EINVAL; /* not implemented */
+		case TIOCGQSIZE:
+			return get_qsize(tty,(struct tty_qsize *) arg);
+		case TIOCSQSIZE:
+			return set_qsize(tty,(struct tty_qsize *) arg);
+		case TIOCGSERIAL:
+			if (!tty->read_q.data)
+				return -EINVAL;
+			return rs_get_serial(tty - tty_table,
+				(struct serial_struct *) arg);
+		case TIOCSSERIAL:
+			if (!tty->read_q.data)
+				return -EINVAL;
+			return rs_set_serial(tty - tty_table,
+				(struct serial_struct *) arg);
+		case TIOCGKEYMAP:
+			if (!IS_CONSOLE(dev))
+				return -EINVAL;
+			return get_keymap((struct kbd_keymap *) arg);
+		case TIOCSKEYMAP:
+			if (!IS_CONSOLE(dev))
+				return -EINVAL;
+			return set_keymap((struct kbd_keymap *) arg);
 		default:
 			return -EINVAL;
 	}
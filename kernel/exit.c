@@ -18,25 +18,23 @@ int sys_pause(void);
 // 关闭指定文件的系统调用
 int sys_close(int fd);
 
-//// 释放指定进程占用的任务槽及其任务数据结构占用的内存页面。
+//// 释放指定进程的任务数据结构、页目录及其进程号。
 // 参数p是任务数据结构指针。该函数在后面的sys_kill()和sys_waitpid()函数中被调用。
-// 扫描任务指针数组表task[]以寻找指定的任务。如果找到，则首先清空该任务槽，然后
-// 释放该任务数据结构所占用的内存页面，最后执行调度函数并在返回时立即退出。如果
-// 在任务数组表中没有找到指定任务对应的项，则内核panic. ;-)
+// 首先把任务从任务链表和进程号散列表中取下，然后释放该任务的页目录和任务数据结构
+// 所占用的内存页面，最后执行调度函数并在返回时立即退出。
 void release(struct task_struct * p)
 {
-	int i;
-
 	if (!p)                         // 如果进程数据结构指针是NULL，则什么也不做，退出。
 		return;
-	for (i=1 ; i<NR_TASKS ; i++)    // 扫描任务数组，寻找指定任务
-		if (task[i]==p) {
-			task[i]=NULL;           // 置空该任务项并释放相关内存页。
-			free_page((long)p);
-			schedule();             // 重新调度(似乎没有必要)
-			return;
-		}
-	panic("trying to release non-existent task");       // 指定任务若不存在则死机
+	if (p == FIRST_TASK)
+		panic("trying to release task 0");
+	REMOVE_LINKS(p);
+	unhash_pid(p);
+	nr_tasks--;
+	p->group->nr_tasks--;
+	free_page(p->thread.cr3);
+	free_page((long)p);
+	schedule();                     // 重新调度(似乎没有必要)
 }
 
 //// 向指定任务p发送信号sig, 权限priv。
@@ -52,23 +50,20 @@ static inline int send_sig(long sig,struct task_struct * p,int priv)
     // 即是自己），或者当前进程是超级用户，则向进程p发送信号sig，即在进程p位图中添加该
     // 信号，否则出错退出。其中suser()定义为(current->euid==0)，用于判断是否是超级用户。
 	if (priv || (current->euid==p->euid) || suser())
-		p->signal |= (1<<(sig-1));
-	else
-		return -EPERM;
-	return 0;
+		return queue_signal(p,sig,0);
+	return -EPERM;
 }
 
 //// 终止会话(session)
 static void kill_session(void)
 {
-	struct task_struct **p = NR_TASKS + task;   // 指针*p首先指向任务数组最末端
+	struct task_struct *p;
 	
-    // 扫描任务指针数组，对于所有的任务(除任务0以外)，如果其会话号session等于当前进程的
+    // 扫描任务链表，对于所有的任务(除任务0以外)，如果其会话号session等于当前进程的
     // 会话号就向它发送挂断进程信号SIGHUP。
-	while (--p > &FIRST_TASK) {
-		if (*p && (*p)->session == current->session)
-			(*p)->signal |= 1<<(SIGHUP-1);      // 发送挂断进程信号
-	}
+	for_each_task(p)
+		if (p->session == current->session)
+			p->signal |= 1<<(SIGHUP-1);      // 发送挂断进程信号
 }
 
 /*
@@ -86,24 +81,26 @@ static void kill_session(void)
 // 表明当前进程是进程组组长，因此需要向所有组内进程强制发送信号sig.
 int sys_kill(int pid,int sig)
 {
-	struct task_struct **p = NR_TASKS + task;
+	struct task_struct *p;
 	int err, retval = 0;
 
-	if (!pid) while (--p > &FIRST_TASK) {
-		if (*p && (*p)->pgrp == current->pid) 
-			if ((err=send_sig(sig,*p,1)))           // 强制发送信号
-				retval = err;
-	} else if (pid>0) while (--p > &FIRST_TASK) {
-		if (*p && (*p)->pid == pid) 
-			if ((err=send_sig(sig,*p,0)))
-				retval = err;
-	} else if (pid == -1) while (--p > &FIRST_TASK) {
-		if ((err = send_sig(sig,*p,0)))
-			retval = err;
-	} else while (--p > &FIRST_TASK)
-		if (*p && (*p)->pgrp == -pid)
-			if ((err = send_sig(sig,*p,0)))
+	if (!pid) {
+		for_each_task(p)
+			if (p->pgrp == current->pid) 
+				if ((err=send_sig(sig,p,1)))           // 强制发送信号
+					retval = err;
+	} else if (pid>0) {
+		if ((p = find_task_by_pid(pid)))
+			retval = send_sig(sig,p,0);
+	} else if (pid == -1) {
+		for_each_task(p)
+			if ((err = send_sig(sig,p,0)))
 				retval = err;
+	} else
+		for_each_task(p)
+			if (p->pgrp == -pid)
+				if ((err = send_sig(sig,p,0)))
+					retval = err;
 	return retval;
 }
 
@@ -112,18 +109,13 @@ int sys_kill(int pid,int sig)
 // 则子进程应该被初始进程1收容。
 static void tell_father(int pid)
 {
-	int i;
+	struct task_struct *p;
 
-	if (pid)
-        // 扫描进城数组表，寻找指定进程pid，并向其发送子进程将停止或终止信号SIGCHLD。
-		for (i=0;i<NR_TASKS;i++) {
-			if (!task[i])
-				continue;
-			if (task[i]->pid != pid)
-				continue;
-			task[i]->signal |= (1<<(SIGCHLD-1));
-			return;
-		}
+    // 寻找指定进程pid，并向其发送子进程将停止或终止信号SIGCHLD。
+	if (pid && (p = find_task_by_pid(pid))) {
+		p->signal |= (1<<(SIGCHLD-1));
+		return;
+	}
 /* if we don't find any fathers, we just release ourselves */
 /* This is not really OK. Must change it to make father 1 */
 	printk("BAD BAD - no father found\n\r");
@@ -136,6 +128,9 @@ static void tell_father(int pid)
 int do_exit(long code)
 {
 	int i;
+	struct task_struct *p;
+	struct tty_struct *tty;
+
     // 首先释放当前进程代码段和数据段所占的内存页。函数free_page_tables()的第一个参数
     // (get_base()返回值)指明在CPU线性地址空间中起始基地址，第2个(get_limit()返回值)
     // 说明欲释放的字节长度值。get_base()宏中的current->ldt[1]给出进程代码段描述符的
@@ -145,14 +140,15 @@ int do_exit(long code)
     // 文件中。
 	free_page_tables(get_base(current->ldt[1]),get_limit(0x0f));
 	free_page_tables(get_base(current->ldt[2]),get_limit(0x17));
+	current->rss = current->shared = 0;
     // 如果当前进程有子进程，就将子进程的father置为1(其父进程改为进程1，即init进程)。
     // 如果该子进程已经处于僵死(ZOMBIE)状态，则向进程1发送子进程中止信号SIGCHLD。
-	for (i=0 ; i<NR_TASKS ; i++)
-		if (task[i] && task[i]->father == current->pid) {
-			task[i]->father = 1;
-			if (task[i]->state == TASK_ZOMBIE)
-				/* assumption task[1] is always init */
-				(void) send_sig(SIGCHLD, task[1], 1);
+	for_each_task(p)
+		if (p->father == current->pid) {
+			p->father = 1;
+			if (p->state == TASK_ZOMBIE)
+				/* assumption pid 1 is always init */
+				(void) send_sig(SIGCHLD, find_task_by_pid(1), 1);
 		}
     // 关闭当前进程打开着的所有文件。
 	for (i=0 ; i<NR_OPEN ; i++)
@@ -167,8 +163,9 @@ int do_exit(long code)
 	iput(current->executable);
 	current->executable=NULL;
     // 如果当前进程是会话头领(leader)进程并且其有控制终端，则释放该终端。
-	if (current->leader && current->tty >= 0)
-		tty_table[current->tty].pgrp = 0;
+	if (current->leader && current->tty >= 0 &&
+	    (tty = get_tty(current->tty)))
+		tty->pgrp = 0;
     // 如果当前进程上次使用过协处理器，则将last_task_used_math置空。
 	if (last_task_used_math == current)
 		last_task_used_math = NULL;
@@ -210,39 +207,36 @@ int sys_exit(int error_code)
 int sys_waitpid(pid_t pid,unsigned long * stat_addr, int options)
 {
 	int flag, code;             // flag标志用于后面表示所选出的子进程处于就绪或睡眠态。
-	struct task_struct ** p;
+	struct task_struct * p;
 
 	verify_area(stat_addr,4);
 repeat:
 	flag=0;
-    // 从任务数组末端开始扫描所有任务，跳过空项、本进程项以及非当前进程的子进程项。
-	for(p = &LAST_TASK ; p > &FIRST_TASK ; --p) {
-		if (!*p || *p == current)
+    // 如果等待的子进程号pid>0，直接从散列表中取出该进程，只检查它一个；否则沿任务链表
+    // 扫描所有任务。跳过本进程项以及非当前进程的子进程项。
+	p = (pid > 0) ? find_task_by_pid(pid) : FIRST_TASK->next_task;
+	for ( ; p && p != FIRST_TASK ; p = (pid > 0) ? NULL : p->next_task) {
+		if (p == current)
 			continue;
-		if ((*p)->father != current->pid)
+		if (p->father != current->pid)
 			continue;
         // 此时扫描选择到的进程p肯定是当前进程的子进程。
-        // 如果等待的子进程号pid>0，但与被扫描子进程p的pid不相等，说明它是当前进程另外的
-        // 子进程，于是跳过该进程，接着扫描下一个进程。
-		if (pid>0) {
-			if ((*p)->pid != pid)
-				continue;
-        // 否则，如果指定等待进程的pid=0,表示正在等待进程组号等于当前进程组号的任何子进程。
+        // 如果指定等待进程的pid=0,表示正在等待进程组号等于当前进程组号的任何子进程。
         // 如果此时被扫描进程p的进程组号与当前进程的组号不等，则跳过。
-		} else if (!pid) {
-			if ((*p)->pgrp != current->pgrp)
+		if (!pid) {
+			if (p->pgrp != current->pgrp)
 				continue;
         // 否则，如果指定的pid < -1,表示正在等待进程组号等于pid绝对值的任何子进程。如果此时
         // 被扫描进程p的组号与pid的绝对值不等，则跳过。
-		} else if (pid != -1) {
-			if ((*p)->pgrp != -pid)
+		} else if (pid < -1) {
+			if (p->pgrp != -pid)
 				continue;
 		}
         // 如果前3个对pid的判断都不符合，则表示当前进程正在等待其任何子进程，也即pid=-1的情况，
         // 此时所选择到的进程p或者是其进程号等于指定pid，或者是当前进程组中的任何子进程，或者
         // 是进程号等于指定pid绝对值的子进程，或者是任何子进程(此时指定的pid等于-1).接下来根据
         // 这个子进程p所处的状态来处理。
-		switch ((*p)->state) {
+		switch (p->state) {
             // 子进程p处于停止状态时，如果此时WUNTRACED标志没有置位，表示程序无须立刻返回，于是
             // 继续扫描处理其他进程。如果WUNTRACED置位，则把状态信息0x7f放入*stat_addr，并立刻
             // 返回子进程号pid.这里0x7f表示的返回状态是wifstopped（）宏为真。
@@ -250,15 +244,15 @@ repeat:
 				if (!(options & WUNTRACED))
 					continue;
 				put_fs_long(0x7f,stat_addr);
-				return (*p)->pid;
+				return p->pid;
             // 如果子进程p处于僵死状态，则首先把它在用户态和内核态运行的时间分别累计到当前进程
             // (父进程)中，然后取出子进程的pid和退出码，并释放该子进程。最后返回子进程的退出码和pid.
 			case TASK_ZOMBIE:
-				current->cutime += (*p)->utime;
-				current->cstime += (*p)->stime;
-				flag = (*p)->pid;                   // 临时保存子进程pid
-				code = (*p)->exit_code;             // 取子进程的退出码
-				release(*p);                        // 释放该子进程
+				current->cutime += p->utime;
+				current->cstime += p->stime;
+				flag = p->pid;                   // 临时保存子进程pid
+				code = p->exit_code;             // 取子进程的退出码
+				release(p);                        // 释放该子进程
 				put_fs_long(code,stat_addr);        // 置状态信息为退出码值
 				return flag;                        // 返回子进程的pid
             // 如果这个子进程p的状态既不是停止也不是僵死，那么就置flag=1,表示找到过一个符合
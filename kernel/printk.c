@@ -36,12 +36,14 @@ int printk(const char *fmt, ...)
 	__asm__("push %%fs\n\t"         // 保存fs
 		"push %%ds\n\t"
 		"pop %%fs\n\t"              // 令fs = ds
-		"pushl %0\n\t"              // 将字符串长度压入堆栈（这三个入栈是调用参数）
+		"pushl $0\n\t"              // 文件标志flags=0(阻塞方式写)
+		"pushl %0\n\t"              // 将字符串长度压入堆栈（这四个入栈是调用参数）
 		"pushl $buf\n\t"            // 将buf的地址压入堆栈
 		"pushl $0\n\t"              // 将数值0压入堆栈，是显示通道号 channel
 		"call tty_write\n\t"        // 调用tty_write函数（tty_io.c）
 		"addl $8,%%esp\n\t"         // 跳过（丢弃）两个入栈参数（buf, channel）
 		"popl %0\n\t"               // 弹出字符串长度值，作为返回值
+		"addl $4,%%esp\n\t"         // 丢弃flags
 		"pop %%fs"                  // 恢复原fs寄存器
 		::"r" (i):"ax","cx","dx");  // 通知编译器，寄存器ax,cx,dx值肯能已经改变。
 	return i;                       // 返回字符串长度
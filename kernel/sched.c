@@ -11,6 +11,7 @@
  * current-task
  */
 #include <linux/sched.h>
+#include <linux/head.h>
 #include <linux/kernel.h>
 #include <linux/sys.h>
 #include <linux/fdreg.h>
@@ -19,6 +20,10 @@
 #include <asm/segment.h>
 
 #include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/taskstats.h>
 
 // 该宏取信号nr在信号位图中对应位的二进制数值。信号编号1-32.比如信号5的位图
 // 数值等于 1 <<(5-1) = 16 = 00010000b
@@ -26,47 +31,43 @@
 // 除了SIGKILL 和SIGSTOP信号以外其他信号都是可阻塞的(...1011,1111,1110,1111,111b)
 #define _BLOCKABLE (~(_S(SIGKILL) | _S(SIGSTOP)))
 
-// 内核调试函数。显示任务号nr的进程号、进程状态和内核堆栈空闲字节数(大约)
-void show_task(int nr,struct task_struct * p)
+// 内核调试函数。显示任务的进程号、进程状态和内核堆栈空闲字节数(大约)
+void show_task(struct task_struct * p)
 {
 	int i,j = 4096-sizeof(struct task_struct);
 
-	printk("%d: pid=%d, state=%d, ",nr,p->pid,p->state);
+	printk("pid=%d, state=%d, ",p->pid,p->state);
 	i=0;
 	while (i<j && !((char *)(p+1))[i])      // 检测指定任务数据结构以后等于0的字节数。
 		i++;
 	printk("%d (of %d) chars free in kernel stack\n\r",i,j);
+	printk("\twait=%d io=%d csw=%d/%d flt=%d/%d\n\r",
+		p->wait_time,p->io_wait,p->nvcsw,p->nivcsw,p->min_flt,p->maj_flt);
 }
 
-// 显示所有任务的任务号、进程号、进程状态和内核堆栈空闲字节数
-// NR_TASKS是系统能容纳的最大进程(任务)数量(64个)。
+// 显示所有任务的进程号、进程状态和内核堆栈空闲字节数
 void show_stat(void)
 {
-	int i;
+	struct task_struct * p;
 
-	for (i=0;i<NR_TASKS;i++)
-		if (task[i])
-			show_task(i,task[i]);
+	show_task(FIRST_TASK);
+	for_each_task(p)
+		show_task(p);
 }
 
 // PC机8253定时芯片的输入时钟频率约为1.193180MHz. Linux内核希望定时器发出中断的频率是
-// 100Hz，也即没10ms发出一次时钟中断。因此这里的LATCH是设置8253芯片的初值。
-#define LATCH (1193180/HZ)
+// 100Hz，也即没10ms发出一次时钟中断。因此这里的LATCH是一个滴答的计数值。
+#define LATCH (CLOCK_TICK_RATE/HZ)
+#define PIT_MAX 0xffff			// 单次定时最长约55ms
 
 extern void mem_use(void);      // 没有任何地方定义和引用该函数
 
 extern int timer_interrupt(void);       // 时钟中断处理程序
 extern int system_call(void);           // 系统调用中断处理程序
+extern int sysenter_entry(void);
+extern long sysenter_stack;
 
-// 每个任务(进程)在内核态运行时都有自己的内核态堆栈。这里定义了任务的内核态堆栈结构。
-// 定义任务联合(任务结构成员和stack字符数组成员)。因为一个任务的数据结构与其内核态堆栈
-// 在同一内存页中，所以从堆栈段寄存器ss可以获得其数据端选择符。
-union task_union {
-	struct task_struct task;
-	char stack[PAGE_SIZE];
-};
-
-static union task_union init_task = {INIT_TASK,};   // 定义初始任务的数据
+union task_union init_task = {INIT_TASK,};          // 定义初始任务的数据
 
 // 从开机开始算起的滴答数时间值全局变量(10ms/滴答)。系统时钟中断每发生一次即一个滴答。
 // 前面的限定符volatile,英文解释是易改变的、不稳定的意思。这个限定词的含义是向编译器
@@ -81,8 +82,15 @@ long volatile jiffies=0;
 long startup_time=0;                                // 开机时间，从1970:0:0:0开始计时
 struct task_struct *current = &(init_task.task);    // 当前任务指针(初始化指向任务0)
 struct task_struct *last_task_used_math = NULL;     // 使用过协处理器任务的指针。
+struct tss_struct tss;                              // 唯一的TSS，switch_to()更新其中的esp0
+
+int nr_tasks = 1;                                   // 现有任务数(包括任务0)
 
-struct task_struct * task[NR_TASKS] = {&(init_task.task), }; // 定义任务指针数组
+// 公平调度组。sched_groups[0]是缺省组，不分组时所有任务都在其中。
+struct sched_group sched_groups[NR_GROUPS] = {
+	{ 0, SCHED_WEIGHT_DEF, SCHED_WEIGHT_DEF, 1 }, };
+int sched_group_mode = SCHED_GROUP_NONE;
+int need_resched = 0;
 
 // 定义用户堆栈，共1K项，容量4K字节。在内核初始化操作过程中被用作内核栈，初始化完成
 // 以后将被用作任务0的用户态堆栈。在运行任务0之前它是内核栈，以后用作任务0和1的用
@@ -109,14 +117,14 @@ void math_state_restore()
     // 在发送协处理器命令之前要先发WAIT指令。如果上个任务使用了协处理器。则保存其状态。
 	__asm__("fwait");
 	if (last_task_used_math) {
-		__asm__("fnsave %0"::"m" (last_task_used_math->tss.i387));
+		__asm__("fnsave %0"::"m" (last_task_used_math->thread.i387));
 	}
     // 现在，last_task_used_math指向当前任务，以备当前任务交换出去时使用。此时如果当前任务
     // 用过协处理器，则恢复其状态。否则的话说明是第一次使用，于是就向协处理器发初始化命令，
     // 并设置使用了协处理器标志。
 	last_task_used_math=current;
 	if (current->used_math) {
-		__asm__("frstor %0"::"m" (current->tss.i387));
+		__asm__("frstor %0"::"m" (current->thread.i387));
 	} else {
 		__asm__("fninit"::);        // 向协处理器发初始化命令
 		current->used_math=1;       // 设置已使用协处理器标志
@@ -131,61 +139,104 @@ void math_state_restore()
  *
  *   NOTE!!  Task 0 is the 'idle' task, which gets called when no other
  * tasks can run. It can not be killed, and it cannot sleep. The 'state'
- * information in task[0] is never used.
+ * information in task 0 is never used.
  */
 void schedule(void)
 {
-	int i,next,c;
-	struct task_struct ** p;
+	int c, gc, rtp;
+	struct task_struct * p, * next, * rt;
+	struct sched_group * g;
 
 /* check alarm, wake up any interruptible tasks that have got a signal */
 
-    // 从任务数组中最后一个任务开始循环检测alarm。在循环时跳过空指针项。
-	for(p = &LAST_TASK ; p > &FIRST_TASK ; --p)
-		if (*p) {
+    // 沿任务链表循环检测alarm。
+	for_each_task(p) {
             // 如果设置过任务的定时值alarm，并且已经过期(alarm<jiffies)，则在
             // 信号位图中置SIGALRM信号，即向任务发送SIGALARM信号。然后清alarm。
             // 该信号的默认操作是终止进程。jiffies是系统从开机开始算起的滴答数(10ms/滴答)。
-			if ((*p)->alarm && (*p)->alarm < jiffies) {
-					(*p)->signal |= (1<<(SIGALRM-1));
-					(*p)->alarm = 0;
-				}
+		if (p->alarm && p->alarm < jiffies) {
+				p->signal |= (1<<(SIGALRM-1));
+				p->alarm = 0;
+			}
             // 如果信号位图中除被阻塞的信号外还有其他信号，并且任务处于可中断状态，则
-            // 置任务为就绪状态。其中'~(_BLOCKABLE & (*p)->blocked)'用于忽略被阻塞的信号，但
+            // 置任务为就绪状态。其中'~(_BLOCKABLE & p->blocked)'用于忽略被阻塞的信号，但
             // SIGKILL 和SIGSTOP不能呗阻塞。
-			if (((*p)->signal & ~(_BLOCKABLE & (*p)->blocked)) &&
-			(*p)->state==TASK_INTERRUPTIBLE)
-				(*p)->state=TASK_RUNNING;
+		if ((p->signal & ~(_BLOCKABLE & p->blocked)) &&
+		p->state==TASK_INTERRUPTIBLE) {
+			p->state=TASK_RUNNING;
+			p->ready_since = jiffies;
 		}
+	}
 
 /* this is the scheduler proper: */
 
+	need_resched = 0;
 	while (1) {
 		c = -1;
-		next = 0;
-		i = NR_TASKS;
-		p = &task[NR_TASKS];
-        // 这段代码也是从任务数组的最后一个任务开始循环处理，并跳过不含任务的数组槽。比较
-        // 每个就绪状态任务的counter(任务运行时间的递减滴答计数)值，哪一个值大，运行时间还
-        // 不长，next就值向哪个的任务号。
-		while (--i) {
-			if (!*--p)
+		gc = -1;
+		rtp = 0;
+		rt = NULL;
+		next = FIRST_TASK;
+        // 沿任务链表比较每个就绪状态任务的counter(任务运行时间的递减滴答计数)值，哪一个值
+        // 大，运行时间还不长，next就指向哪个任务。分组时先比较所在组的counter，组内再比较
+        // 任务的counter(不分组时所有任务都在缺省组中，组counter都相同)。
+		for_each_task(p) {
+			if (p->state != TASK_RUNNING)
+				continue;
+        // 实时任务另行比较：rt指向优先级最高的，同优先级时counter大的(对SCHED_RR而言即这一轮
+        // 还没有用完时间片的)。
+			if (p->policy != SCHED_OTHER) {
+				if (p->rt_priority > rtp ||
+				    (p->rt_priority == rtp && p->counter > rt->counter))
+					rtp = p->rt_priority, rt = p;
 				continue;
-			if ((*p)->state == TASK_RUNNING && (*p)->counter > c)
-				c = (*p)->counter, next = i;
+			}
+			if (p->group->counter > gc ||
+			    (p->group->counter == gc && p->counter > c))
+				gc = p->group->counter, c = p->counter, next = p;
+		}
+        // 有就绪的实时任务时总是先运行它。若同优先级的SCHED_RR任务都已用完时间片，则给它们
+        // 重新分配时间片后再选一次，这样它们就轮流运行。
+		if (rt) {
+			if (rt->counter || rt->policy == SCHED_FIFO) {
+				next = rt;
+				break;
+			}
+			for_each_task(p)
+				if (p->policy == SCHED_RR && p->rt_priority == rtp)
+					p->counter = p->priority;
+			continue;
+		}
+        // 分组时若选中组的时间片已用完，说明所有有就绪任务的组都已用完，则按权重给每个组
+        // 重新分配：counter = counter/2 + weight，然后重新选择。
+		if (sched_group_mode && !gc) {
+			for (g = sched_groups ; g < sched_groups + NR_GROUPS ; g++)
+				g->counter = (g->counter >> 1) + g->weight;
+			continue;
 		}
         // 如果比较得出有counter值不等于0的结果，或者系统中没有一个可运行的任务存在(此时c
-        // 仍然为-1，next=0),则退出while(1)_的循环，执行switch任务切换操作。否则就根据每个
+        // 仍然为-1，next为任务0),则退出while(1)_的循环，执行switch任务切换操作。否则就根据每个
         // 任务的优先权值，更新每一个任务的counter值，然后回到while(1)循环。counter值的计算
-        // 方式counter＝counter/2 + priority.注意：这里计算过程不考虑进程的状态。
+        // 方式counter＝counter/2 + priority.注意：这里计算过程不考虑进程的状态。分组时只
+        // 更新选中组内的任务，其他组的任务不会因此多得时间。
 		if (c) break;
-		for(p = &LAST_TASK ; p > &FIRST_TASK ; --p)
-			if (*p)
-				(*p)->counter = ((*p)->counter >> 1) +
-						(*p)->priority;
+		for_each_task(p)
+			if (p->policy == SCHED_OTHER &&
+			    (!sched_group_mode || p->group == next->group))
+				p->counter = (p->counter >> 1) + p->priority;
+	}
+    // 统计切换：当前任务若仍就绪则是被抢占(被迫切换)，否则是自己睡眠(自愿切换)。
+    // next在就绪队列中等待的时间计入其wait_time。
+	if (next != current) {
+		if (current->state == TASK_RUNNING) {
+			current->nivcsw++;
+			current->ready_since = jiffies;
+		} else
+			current->nvcsw++;
+		next->wait_time += jiffies - next->ready_since;
 	}
-    // 用下面的宏把当前任务指针current指向任务号Next的任务，并切换到该任务中运行。上面Next
-    // 被初始化为0。此时任务0仅执行pause()系统调用，并又会调用本函数。
+    // 用下面的宏把当前任务指针current指向任务next，并切换到该任务中运行。上面next
+    // 被初始化为任务0。此时任务0仅执行pause()系统调用，并又会调用本函数。
 	switch_to(next);     // 切换到Next任务并运行。
 }
 
@@ -197,91 +248,125 @@ int sys_pause(void)
 {
 	current->state = TASK_INTERRUPTIBLE;
 	schedule();
+/* if task 0 gets back here, nobody else wanted the cpu */
+	if (current == FIRST_TASK) {
+		zero_idle_page();
+		tick_idle();
+	}
 	return 0;
 }
 
-// 把当前任务置为不可中断的等待状态，并让睡眠队列指针指向当前任务。
-// 只有明确的唤醒时才会返回。该函数提供了进程与中断处理程序之间的同步机制。函数参数P是等待
-// 任务队列头指针。指针是含有一个变量地址的变量。这里参数p使用了指针的指针形式'**p',这是因为
-// C函数参数只能传值，没有直接的方式让被调用函数改变调用该函数程序中变量的值。但是指针'*p'
-// 指向的目标(这里是任务结构)会改变，因此为了能修改调用该函数程序中原来就是指针的变量的值，
-// 就需要传递指针'*p'的指针，即'**p'.
+// 把当前任务挂到等待队列*q上并睡眠。队列项wait位于本任务的内核栈上，睡眠期间一直有效。
+// 非互斥等待者插在队首；互斥等待者插在队尾，这样wake_up()顺着链表走时总是先唤醒全部
+// 非互斥者，再唤醒一个互斥者。被唤醒返回后由本任务自己把队列项摘下，因此wake_up()只需
+// 修改任务状态，无需改动链表。整个过程在关中断下进行，以免与中断中的wake_up()冲突。
 /* TASK_UNINTERRUPTIBLE状态存在的意义就在于，内核的某些处理流程是不能被打断的。如果响应异步信号，
  * 程序的执行流程中就会被插入一段用于处理异步信号的流程（这个插入的流程可能只存在于内核态，也可能延
  * 伸到用户态），于是原有的流程就被中断了。（kill -9杀不死一个处于TASK_UNINTERRUPTIBLE状态的进程）
  */
-void sleep_on(struct task_struct **p)
+static void __sleep_on(struct wait_queue ** q, int state, int exclusive)
 {
-	struct task_struct *tmp;
+	struct wait_queue wait = { current, exclusive, NULL };
+	struct wait_queue ** p;
+	unsigned long flags;
 
-    // 若指针无效，则退出。(指针所指向的对象可以是NULL，但指针本身不应该为0).另外，如果
-    // 当前任务是任务0，则死机。因为任务0的运行不依赖自己的状态，所以内核代码把任务0置为
-    // 睡眠状态毫无意义。
-	if (!p)
-		return;
-	if (current == &(init_task.task))
-		panic("task[0] trying to sleep");
-    // 让tmp指向已经在等待队列上的任务(如果有的话)，例如inode->i_wait.并且将睡眠队列头的
-    // 等等指针指向当前任务。这样就把当前任务插入到了*p的等待队列中。然后将当前任务置为
-    // 不可中断的等待状态，并执行重新调度。
-	tmp = *p;
-	*p = current;
-	current->state = TASK_UNINTERRUPTIBLE;
-	schedule();
-    // 只有当这个等待任务被唤醒时，调度程序才又返回到这里，表示本进程已被明确的唤醒(就
-    // 续态)。既然大家都在等待同样的资源，那么在资源可用时，就有必要唤醒所有等待该该资源
-    // 的进程。该函数嵌套调用，也会嵌套唤醒所有等待该资源的进程。这里嵌套调用是指一个
-    // 进程调用了sleep_on()后就会在该函数中被切换掉，控制权呗转移到其他进程中。此时若有
-    // 进程也需要使用同一资源，那么也会使用同一个等待队列头指针作为参数调用sleep_on()函数，
-    // 并且也会陷入该函数而不会返回。只有当内核某处代码以队列头指针作为参数wake_up了队列，
-    // 那么当系统切换去执行头指针所指的进程A时，该进程才会继续执行下面的代码，把队列后一个
-    // 进程B置位就绪状态(唤醒)。而当轮到B进程执行时，它也才可能继续执行下面的代码。若它
-    // 后面还有等待的进程C，那它也会把C唤醒等。在这前面还应该添加一行：*p = tmp.
-	if (tmp)                    // 若在其前还有存在的等待的任务，则也将其置为就绪状态(唤醒).
-		tmp->state=0;
-}
-
-// 将当前任务置为可中断的等待状态，并放入*p指定的等待队列中。
-void interruptible_sleep_on(struct task_struct **p)
-{
-	struct task_struct *tmp;
-
-    // 若指针无效，则退出。(指针所指向的对象可以是NULL，但指针本身不会为0).如果当前任务是
-    // 任务0，则死机。
-	if (!p)
+	if (!q)
 		return;
-	if (current == &(init_task.task))
+	if (current == FIRST_TASK)
 		panic("task[0] trying to sleep");
-    // 让tmp指向已经在等待队列上的任务(如果有的话)，例如inode->i_wait。并且将睡眠队列头的
-    // 等待指针指向当前任务。这样就把当前任务插入到了*p的等待队列中。然后将当前任务置为可
-    // 中断的等待状态，并执行重新调度。
-	tmp=*p;
-	*p=current;
-repeat:	current->state = TASK_INTERRUPTIBLE;
+	save_flags(flags);
+	cli();
+	p = q;
+	if (exclusive)
+		while (*p)
+			p = &(*p)->next;
+	wait.next = *p;
+	*p = &wait;
+	current->state = state;
 	schedule();
-    // 只有当这个等待任务被唤醒时，程序才又会回到这里，标志进程已被明确的唤醒执行。如果等待
-    // 队列中还有等待任务，并且队列头指针所指向的任务不是当前任务时，则将该等待任务置为可运行
-    // 的就绪状态，并重新执行调度程序。当指针*p所指向的不是当前任务时，表示在当前任务被被放入
-    // 队列后，又有新的任务被插入等待队列前部。因此我们先唤醒他们，而让自己仍然等等。等待这些
-    // 后续进入队列的任务被唤醒执行时来唤醒本任务。于是去执行重新调度。
-	if (*p && *p != current) {
-		(**p).state=0;
-		goto repeat;
-	}
-    // 下一句代码有误：应该是 *p = tmp, 让队列头指针指向其余等待任务，否则在当前任务之前插入
-    // 等待队列的任务均被抹掉了。当然同时也需要删除下面行数中同样的语句
-	*p=NULL;
-	if (tmp)
-		tmp->state=0;
+// 被唤醒后（或可中断睡眠时收到信号后）从队列中摘除自己。
+	for (p = q ; *p ; p = &(*p)->next)
+		if (*p == &wait) {
+			*p = wait.next;
+			break;
+		}
+	restore_flags(flags);
 }
 
-// 唤醒*p指向的让任务。*p是任务等待队列头指针。由于新等待任务是插入在等待队列头指针处的，
-// 因此唤醒的是最后进入等待队列的任务。
-void wake_up(struct task_struct **p)
+// 不可中断的睡眠。wake_up()时与其他非互斥等待者一起被唤醒。
+void sleep_on(struct wait_queue ** q)
 {
-	if (p && *p) {
-		(**p).state=0;          // 置为就绪(可运行)状态TASK_RUNNING.
-		*p=NULL;
+	__sleep_on(q,TASK_UNINTERRUPTIBLE,0);
+}
+
+// 可中断的睡眠。信号也会使其返回，调用者需自行检查等待条件。
+void interruptible_sleep_on(struct wait_queue ** q)
+{
+	__sleep_on(q,TASK_INTERRUPTIBLE,0);
+}
+
+// 互斥的不可中断睡眠，用于等待锁一类的资源：每次wake_up()只唤醒一个这样的等待者，
+// 其余的继续睡眠，由得到资源的任务释放时再唤醒下一个。
+void sleep_on_exclusive(struct wait_queue ** q)
+{
+	__sleep_on(q,TASK_UNINTERRUPTIBLE,1);
+}
+
+// 把队列项wait加到等待队列*q的头部(非互斥)，用于同时等待多个队列的select()/poll()。
+// 调用者自己设置任务状态并调用schedule()，最后用remove_wait_queue()摘除。
+void add_wait_queue(struct wait_queue ** q, struct wait_queue * wait)
+{
+	unsigned long flags;
+
+	save_flags(flags);
+	cli();
+	wait->next = *q;
+	*q = wait;
+	restore_flags(flags);
+}
+
+void remove_wait_queue(struct wait_queue ** q, struct wait_queue * wait)
+{
+	unsigned long flags;
+
+	save_flags(flags);
+	cli();
+	for ( ; *q ; q = &(*q)->next)
+		if (*q == wait) {
+			*q = wait->next;
+			break;
+		}
+	restore_flags(flags);
+}
+
+// 把任务p置为就绪。若它是比当前任务优先级更高的实时任务，则置need_resched，让中断
+// 或系统调用返回用户态之前就切换过去，而不用等当前任务的时间片用完。
+void wake_up_process(struct task_struct * p)
+{
+	if (p->state != TASK_RUNNING)
+		p->ready_since = jiffies;
+	p->state = TASK_RUNNING;
+	if (p->policy != SCHED_OTHER && (current->policy == SCHED_OTHER ||
+	    p->rt_priority > current->rt_priority))
+		need_resched = 1;
+}
+
+// 唤醒等待队列*q。所有非互斥等待者都被置为就绪，互斥等待者只唤醒第一个尚未就绪的。
+// 队列项由被唤醒的任务自己摘除，所以这里可在中断中调用。
+void wake_up(struct wait_queue ** q)
+{
+	struct wait_queue * p;
+
+	if (!q)
+		return;
+	for (p = *q ; p ; p = p->next) {
+		if (p->exclusive) {
+			if (p->task->state == TASK_RUNNING)
+				continue;
+			wake_up_process(p->task);
+			break;
+		}
+		wake_up_process(p->task);
 	}
 }
 
@@ -293,7 +378,7 @@ void wake_up(struct task_struct **p)
 // 下面代码用于处理软驱定时。在阅读这段代码之前请先看一下块设备中的驱动程序(floppy.c)后面
 // 的说明，或者到阅读软盘块设备驱动程序时再来看这段代码。其实时间单位：1个滴答=1/100秒。
 // 下面数组存放等待软驱马达启动到正常转速的进程指针。数组索引0-3分别对应软驱A-D。
-static struct task_struct * wait_motor[4] = {NULL,NULL,NULL,NULL};
+static struct wait_queue * wait_motor[4] = {NULL,NULL,NULL,NULL};
 // 下面数组分别存放各软驱马达启动所需的滴答数。程序中默认启动时间为50个滴答(0.5秒)。
 static int  mon_timer[4]={0,0,0,0};
 // 下面数组分别存放各软驱在马达停转之前需维持的时间。程序中设定为10000个滴答(100秒)
@@ -394,6 +479,10 @@ static struct timer_list {
 	struct timer_list * next;       // 链接指向下一个定时器
 } timer_list[TIME_REQUESTS], * next_timer = NULL;   // next_timer是定时器队列头指针
 
+static int tick_stopped = 0;		// 空闲任务已停掉周期滴答
+
+void do_timer(long cpl);
+
 // 添加定时器。输入参数为指定的定时值(滴答数)和相应的处理程序指针。
 // 软盘驱动程序(floppy.c)利用该函数执行启动或关闭马达的延时操作。
 // 参数jiffies - 以10毫秒计的滴答数：*fn() - 定时时间到时执行的函数
@@ -405,6 +494,9 @@ void add_timer(long jiffies, void (*fn)(void))
 	if (!fn)
 		return;
 	cli();
+    // 滴答停掉时jiffies可能落后，先让时钟赶上，定时值才是从现在算起的。
+	if (tick_stopped)
+		do_timer(0);
     // 如果定时值 <= 0,则立刻调用其处理程序。并且该定时器不加入链表中。
 	if (jiffies <= 0)
 		(fn)();
@@ -436,56 +528,299 @@ void add_timer(long jiffies, void (*fn)(void))
 			p->next->jiffies = jiffies;
 			p = p->next;
 		}
+		if (tick_stopped)
+			do_timer(0);		/* re-arm the PIT for the new timer */
 	}
 	sti();
 }
 
+/*
+ * The PIT runs in one-shot mode (mode 0) and is re-armed on every timer
+ * interrupt for the next event: the next jiffy while anything is running,
+ * or the next timer, alarm or hrtimer (at most PIT_MAX cycles away) once
+ * the idle task has stopped the tick. Time is kept in PIT cycles and
+ * jiffies are counted off it, so a long idle sleep still ages everything
+ * by the right number of ticks.
+ */
+// 时钟芯片工作于单次计数方式，每次中断后重新设定下一个事件到来的计数值。系统忙时下一个事件
+// 就是下一个滴答；空闲任务停掉滴答后则是最近的定时器、报警或高精度定时器。时间以PIT计数
+// 周期为单位累计，jiffies由其换算得到，因此长时间空闲之后滴答数仍然准确。
+static unsigned long long pit_clock = 0;	// 开机以来的PIT周期数(截至上次clock_update())
+static unsigned long pit_count;		// 上次装入的计数值
+static unsigned long pit_seen;		// 装入以来已计入pit_clock的周期数
+static long tick_frac = 0;		// 自上一个滴答以来的周期数
+static long idle_until = 0;		// 空闲时需在该滴答醒来处理报警(0 - 无)
+static struct hrtimer * next_hrtimer = NULL;	// 按到期时间排序的高精度定时器链表
+
+extern int beepcount;               // 扬声器发声滴答数
+extern void sysbeepstop(void);      // 关闭扬声器。
+
+// 装入新的计数值，方式0在计数到0时产生一次中断。调用前要用clock_catch_up()把
+// 旧计数值下走过的周期计入时钟。
+static void pit_program(long long count)
+{
+	if (count < 2)
+		count = 2;
+	if (count > PIT_MAX)
+		count = PIT_MAX;
+	pit_count = count;
+	pit_seen = 0;
+	outb_p(0x30,0x43);		/* binary, mode 0, LSB/MSB, ch 0 */
+	outb_p(pit_count & 0xff,0x40);
+	outb(pit_count >> 8,0x40);
+}
+
+// 读出自上次装入计数值以来经过的周期数。用8254的回读命令同时锁存状态和计数值：状态
+// 字节位7是OUT引脚，为1表示已计到0并回绕；位6为1表示新计数值还未装入。
+static unsigned long pit_elapsed(void)
+{
+	unsigned char status;
+	unsigned long count;
+
+	outb_p(0xc2,0x43);		/* read-back: latch count and status of ch 0 */
+	status = inb_p(0x40);
+	count = inb_p(0x40);
+	count |= inb_p(0x40) << 8;
+	if (status & 0x40)
+		return 0;
+	if (status & 0x80)
+		return pit_count + ((0x10000 - count) & 0xffff);
+	return pit_count - count;
+}
+
+// 取当前时间(PIT周期数)，可在任意上下文中调用。
+unsigned long long get_cycles(void)
+{
+	unsigned long long now;
+	unsigned long flags;
+
+	save_flags(flags);
+	cli();
+	now = pit_clock + pit_elapsed();
+	now = (now > pit_clock + pit_seen) ? now - pit_seen : pit_clock;
+	restore_flags(flags);
+	return now;
+}
+
+// 把自上次读取以来走过的周期计入时钟。必须关中断调用。
+static void clock_catch_up(void)
+{
+	unsigned long n = pit_elapsed();
+
+	if (n > pit_seen) {
+		pit_clock += n - pit_seen;
+		tick_frac += n - pit_seen;
+		pit_seen = n;
+	}
+}
+
+// 把经过的周期计入时钟，返回其间走过的滴答数。必须关中断调用，且随后要重新设定PIT。
+static long clock_update(void)
+{
+	long ticks = 0;
+
+	clock_catch_up();
+	while (tick_frac >= LATCH) {
+		tick_frac -= LATCH;
+		ticks++;
+	}
+	jiffies += ticks;
+	return ticks;
+}
+
+/*
+ * Re-arm the PIT for the next event. The counter has kept running since
+ * clock_update() read it (hrtimer callbacks, timers, floppy), so those
+ * cycles are added to the clock first, or it would fall behind on every
+ * interrupt. A tick that fell due meanwhile makes delta <= 0, which
+ * pit_program() turns into an interrupt right away.
+ */
+// 按最近的事件重新设定PIT。先把clock_update()之后走过的周期计入时钟，否则每次中断
+// 都会丢掉这段时间。
+static void program_next_event(void)
+{
+	long long delta, d;
+
+	clock_catch_up();
+	delta = LATCH - tick_frac;
+	if (tick_stopped) {
+		delta = PIT_MAX;
+		if (next_timer) {
+			d = next_timer->jiffies * (long long) LATCH - tick_frac;
+			if (d < delta)
+				delta = d;
+		}
+		if (idle_until && idle_until - jiffies <= PIT_MAX/LATCH + 1) {
+			d = (idle_until > jiffies) ?
+				(idle_until - jiffies) * (long long) LATCH - tick_frac : 0;
+			if (d < delta)
+				delta = d;
+		}
+	}
+	if (next_hrtimer) {
+		d = (next_hrtimer->expires > pit_clock) ?
+			next_hrtimer->expires - pit_clock : 0;
+		if (d < delta)
+			delta = d;
+	}
+	pit_program(delta);
+}
+
+// 运行所有已到期的高精度定时器。
+static void run_hrtimers(void)
+{
+	struct hrtimer * t;
+	void (*fn)(long);
+
+	while ((t = next_hrtimer) && t->expires <= pit_clock) {
+		next_hrtimer = t->next;
+		fn = t->fn;
+		t->fn = NULL;
+		fn(t->data);
+	}
+}
+
+// 按到期时间把高精度定时器插入链表。若它成为第一个，则立即按它重新设定PIT。
+void add_hrtimer(struct hrtimer * t)
+{
+	struct hrtimer ** p;
+	unsigned long flags;
+
+	save_flags(flags);
+	cli();
+	for (p = &next_hrtimer ; *p && (*p)->expires <= t->expires ; p = &(*p)->next)
+		/* nothing */ ;
+	t->next = *p;
+	*p = t;
+	if (next_hrtimer == t)
+		do_timer(0);		/* catch the clock up and re-arm the PIT */
+	restore_flags(flags);
+}
+
+// 从链表中删除尚未到期的高精度定时器。
+void del_hrtimer(struct hrtimer * t)
+{
+	struct hrtimer ** p;
+	unsigned long flags;
+
+	save_flags(flags);
+	cli();
+	for (p = &next_hrtimer ; *p ; p = &(*p)->next)
+		if (*p == t) {
+			*p = t->next;
+			t->fn = NULL;
+			break;
+		}
+	restore_flags(flags);
+}
+
 /// 时钟中断C函数处理程序，在system_call.s中timer_interrupt被调用。
 // 参数cpl是当前特权级0或3，是时钟中断发生时正在被执行的代码选择符中的特权级。
 // cpl=0时表示中断发生时正在执行内核代码；cpl=3表示中断发生时正在执行用户代码。
-// 对于一个进程由于执行时间片用完时，则进城任务切换。并执行一个计时更新工作。
+// 一次中断可能对应多个滴答(空闲时停掉了滴答)，也可能一个也没有(只是高精度定时器到期)。
+// 内核中需要让时钟赶上当前时间并重设PIT时，也以cpl=0关中断调用它。
 void do_timer(long cpl)
 {
-	extern int beepcount;               // 扬声器发声滴答数
-	extern void sysbeepstop(void);      // 关闭扬声器。
+	long ticks, left;
 
+	ticks = clock_update();
+	run_hrtimers();
+	if (ticks) {
     // 如果发声计数次数到，则关闭发声。(向0x61口发送命令，复位位0和1，位0
     // 控制8253计数器2的工作，位1控制扬声器)
-	if (beepcount)
-		if (!--beepcount)
+		if (beepcount > 0 && (beepcount -= ticks) <= 0) {
+			beepcount = 0;
 			sysbeepstop();
+		}
 
     // 如果当前特权级(cpl)为0，则将内核代码运行时间stime递增；
-	if (cpl)
-		current->utime++;
-	else
-		current->stime++;
-
-    // 如果有定时器存在，则将链表第1个定时器的值减1.如果已等于0，则调用相应的
-    // 处理程序，并将该处理程序指针置空。然后去掉该项定时器。next_timer是定时器
-    // 链表的头指针。  
-	//TODO 为什么这里只处理第一个timer？
-	if (next_timer) {
-		next_timer->jiffies--;
-		while (next_timer && next_timer->jiffies <= 0) {
-			void (*fn)(void);       // 这里插入了一个函数指针定义!!!! o(︶︿︶)o 
-			fn = next_timer->fn;
-			next_timer->fn = NULL;
-			next_timer = next_timer->next;
-			(fn)();                 // 调用处理函数
+		if (cpl)
+			current->utime += ticks;
+		else
+			current->stime += ticks;
+
+    // 定时器链表中的值是相对前一项的滴答数。第1个定时器减去经过的滴答数，到期的调用相应
+    // 的处理程序，并将该处理程序指针置空，然后去掉该项；多减的部分从下一项中扣除。
+		if (next_timer) {
+			next_timer->jiffies -= ticks;
+			while (next_timer && next_timer->jiffies <= 0) {
+				void (*fn)(void);
+				left = next_timer->jiffies;
+				fn = next_timer->fn;
+				next_timer->fn = NULL;
+				next_timer = next_timer->next;
+				if (next_timer)
+					next_timer->jiffies += left;
+				(fn)();                 // 调用处理函数
+			}
 		}
-	}
     // 如果当前软盘控制器FDC的数字输出寄存器中马达启动位有置位的，则执行软盘定时程序
-	if (current_DOR & 0xf0)
-		do_floppy_timer();
-    // 如果进程运行时间还没完，则退出。否则置当前任务计数值为0.并且若发生时钟中断
-    // 正在内核代码中运行则返回，否则调用执行调度函数。
-	if ((--current->counter)>0) return;
-	current->counter=0;
+		for (left = ticks ; left > 0 && (current_DOR & 0xf0) ; left--)
+			do_floppy_timer();
+	}
+	program_next_event();
+    // SCHED_FIFO任务没有时间片，只在更高优先级的实时任务就绪时才让出CPU。
+	if (current->policy == SCHED_FIFO) {
+		if (need_resched && cpl)
+			schedule();
+		return;
+	}
+    // 分组时同时扣除当前任务所在组的时间片。组的时间片用完时也要重新调度，让别的组运行。
+	if (current->policy == SCHED_OTHER && sched_group_mode &&
+	    current != FIRST_TASK && (current->group->counter -= ticks) <= 0)
+		current->group->counter = 0;
+    // 如果进程运行时间还没完并且没有实时任务等着抢占，则退出。否则置当前任务计数值为0.
+    // 并且若发生时钟中断正在内核代码中运行则返回，否则调用执行调度函数。
+	if ((current->counter -= ticks) > 0 && !need_resched &&
+	    (current->policy != SCHED_OTHER || !sched_group_mode ||
+	     current->group->counter))
+		return;
+	if (current->counter < 0)
+		current->counter=0;
 	if (!cpl) return;                       // 内核态程序不依赖counter值进行调度
 	schedule();
 }
 
+/*
+ * Called by the idle task when schedule() found nothing to run. The tick
+ * is stopped (unless the floppy motor or the speaker still count ticks)
+ * and the cpu halts until an interrupt makes some task runnable.
+ */
+// 空闲任务在没有可运行任务时调用。停掉周期滴答(软驱马达或扬声器仍在计时时除外)，
+// 然后hlt，直到某个中断使任务就绪、有信号要处理或报警到期。
+void tick_idle(void)
+{
+	struct task_struct * p;
+	long until;
+
+	for (;;) {
+		cli();
+		until = 0;
+		for_each_task(p) {
+			if (p->state == TASK_RUNNING)
+				goto out;
+			if ((p->signal & ~(_BLOCKABLE & p->blocked)) &&
+			    p->state == TASK_INTERRUPTIBLE)
+				goto out;
+			if (p->alarm && (!until || p->alarm < until))
+				until = p->alarm;
+		}
+		if (until && until < jiffies)
+			goto out;
+		idle_until = until ? until + 1 : 0;
+		tick_stopped = !beepcount && !(current_DOR & 0xf0);
+		do_timer(0);				/* re-arm for the next event */
+		__asm__ __volatile__("sti ; hlt");
+	}
+out:
+	if (tick_stopped) {
+		tick_stopped = 0;
+		do_timer(0);				/* back to the periodic tick */
+	}
+	sti();
+}
+
+
 // 系统调用功能 - 设置报警定时时间值(秒)
 // 如果参数seconds大于0，则设置新定时值，并返回原定时时刻还剩余的间隔时间。否则
 // 返回0.进程数据结构中报警定时值alarm的单位是系统滴答(1滴答为10ms),它是系统开机起
@@ -502,6 +837,228 @@ int sys_alarm(long seconds)
 	return (old);
 }
 
+// 取任务p在当前分组方式下的组号。
+static long group_id(struct task_struct * p)
+{
+	switch (sched_group_mode) {
+		case SCHED_GROUP_SESSION: return p->session;
+		case SCHED_GROUP_PGRP: return p->pgrp;
+		case SCHED_GROUP_UID: return p->uid;
+	}
+	return 0;
+}
+
+// 查找组号为id的组。create非0时若不存在则取一个空闲项；不分组或表已满时返回缺省组。
+static struct sched_group * find_group(long id, int create)
+{
+	struct sched_group * g, * empty = NULL;
+
+	if (!sched_group_mode)
+		return sched_groups;
+	for (g = sched_groups + 1 ; g < sched_groups + NR_GROUPS ; g++) {
+		if (g->nr_tasks && g->id == id)
+			return g;
+		if (!g->nr_tasks && !empty)
+			empty = g;
+	}
+	if (!create)
+		return NULL;
+	if (!empty)
+		return sched_groups;
+	empty->id = id;
+	empty->counter = empty->weight = SCHED_WEIGHT_DEF;
+	return empty;
+}
+
+/*
+ * Called whenever something that decides p's group changes: fork and
+ * release, setsid, setpgid, setuid, and a change of sched_group_mode.
+ */
+void sched_regroup(struct task_struct * p)
+{
+	struct sched_group * g;
+	unsigned long flags;
+
+	save_flags(flags);
+	cli();
+	g = find_group(group_id(p),1);
+	if (g != p->group) {
+		p->group->nr_tasks--;
+		g->nr_tasks++;
+		p->group = g;
+	}
+	restore_flags(flags);
+}
+
+// 系统调用 - 公平调度组的设置和查询，cmd见<sched.h>。
+int sys_sched_group(int cmd, long id, int arg)
+{
+	struct sched_group * g;
+	struct task_struct * p;
+
+	switch (cmd) {
+		case SG_GETMODE:
+			return sched_group_mode;
+		case SG_SETMODE:
+			if (!suser())
+				return -EPERM;
+			if (arg < SCHED_GROUP_NONE || arg > SCHED_GROUP_UID)
+				return -EINVAL;
+			cli();
+			sched_group_mode = arg;
+			for_each_task(p)
+				sched_regroup(p);
+			sti();
+			return 0;
+		case SG_GETWEIGHT:
+			if (!(g = find_group(id,0)))
+				return -ESRCH;
+			return g->weight;
+		case SG_SETWEIGHT:
+			if (arg < 1 || arg > SCHED_WEIGHT_MAX)
+				return -EINVAL;
+			if (!(g = find_group(id,0)))
+				return -ESRCH;
+    // 普通用户只能降低自己所在组的权重，缺省组(0号)是大家共用的，也不能改。
+			if (!suser() && (arg > g->weight || g != current->group ||
+			    g == sched_groups))
+				return -EPERM;
+			g->weight = arg;
+			return 0;
+	}
+	return -EINVAL;
+}
+
+// 系统调用 - 设置任务pid(0表示当前任务)的调度策略和实时优先级。只有超级用户能设置实时
+// 策略；普通用户只能把自己的任务改回SCHED_OTHER。
+int sys_sched_setscheduler(int pid, int policy, struct sched_param * param)
+{
+	struct task_struct * p;
+	long prio;
+
+	if (!(p = pid ? find_task_by_pid(pid) : current))
+		return -ESRCH;
+	prio = get_fs_long((unsigned long *) &param->sched_priority);
+	if (policy == SCHED_OTHER) {
+		if (prio)
+			return -EINVAL;
+	} else if (policy == SCHED_FIFO || policy == SCHED_RR) {
+		if (prio < SCHED_PRIO_MIN || prio > SCHED_PRIO_MAX)
+			return -EINVAL;
+		if (!suser())
+			return -EPERM;
+	} else
+		return -EINVAL;
+	if (!suser() && current->euid != p->euid && current->euid != p->uid)
+		return -EPERM;
+	cli();
+	p->policy = policy;
+	p->rt_priority = prio;
+	if (!p->counter)
+		p->counter = p->priority;
+	need_resched = 1;
+	sti();
+	return 0;
+}
+
+// 系统调用 - 取任务pid(0表示当前任务)的调度策略。
+int sys_sched_getscheduler(int pid)
+{
+	struct task_struct * p;
+
+	if (!(p = pid ? find_task_by_pid(pid) : current))
+		return -ESRCH;
+	return p->policy;
+}
+
+// 系统调用 - 取任务pid(0表示当前任务)的实时优先级。
+int sys_sched_getparam(int pid, struct sched_param * param)
+{
+	struct task_struct * p;
+
+	if (!(p = pid ? find_task_by_pid(pid) : current))
+		return -ESRCH;
+	verify_area(param,sizeof(*param));
+	put_fs_long(p->rt_priority,(unsigned long *) &param->sched_priority);
+	return 0;
+}
+
+// 系统调用 - 取任务pid(0表示当前任务)的调度与延迟统计信息，见<sys/taskstats.h>。
+int sys_taskstats(int pid, struct taskstats * buf)
+{
+	struct task_struct * p;
+	struct taskstats ts;
+	int i;
+
+	if (!(p = pid ? find_task_by_pid(pid) : current))
+		return -ESRCH;
+	ts.state = p->state;
+	ts.policy = p->policy;
+	ts.priority = p->policy == SCHED_OTHER ? p->priority : p->rt_priority;
+	ts.utime = p->utime;
+	ts.stime = p->stime;
+	ts.wait_time = p->wait_time;
+	if (p->state == TASK_RUNNING && p != current)
+		ts.wait_time += jiffies - p->ready_since;
+	ts.io_wait = p->io_wait;
+	ts.nvcsw = p->nvcsw;
+	ts.nivcsw = p->nivcsw;
+	ts.min_flt = p->min_flt;
+	ts.maj_flt = p->maj_flt;
+	verify_area(buf,sizeof(ts));
+	for (i = 0 ; i < sizeof(ts)/sizeof(long) ; i++)
+		put_fs_long(((unsigned long *) &ts)[i],i + (unsigned long *) buf);
+	return 0;
+}
+
+// 高精度定时器到期时唤醒任务data(nanosleep()、select()和poll()的超时)。
+void hrtimer_wakeup(long data)
+{
+	wake_up_process((struct task_struct *) data);
+}
+
+// 系统调用 - 睡眠指定的秒数和纳秒数。用高精度定时器唤醒，精度约1微秒，而不是一个滴答。
+// 被信号中断时返回-EINTR，并在rmtp(若非空)中填入剩余的时间。
+int sys_nanosleep(struct timespec * rqtp, struct timespec * rmtp)
+{
+	struct hrtimer t;
+	unsigned long long now;
+	unsigned long sec, nsec, rem;
+
+	sec = get_fs_long((unsigned long *) &rqtp->tv_sec);
+	nsec = get_fs_long((unsigned long *) &rqtp->tv_nsec);
+	if ((long) sec < 0 || nsec >= 1000000000)
+		return -EINVAL;
+/* cycles = nsec * CLOCK_TICK_RATE / 10^9, rounded up, without a 64-bit divide */
+	t.expires = get_cycles() + sec * (unsigned long long) CLOCK_TICK_RATE +
+		((nsec * 5124670ULL) >> 32) + 1;
+	t.fn = hrtimer_wakeup;
+	t.data = (long) current;
+	cli();
+	add_hrtimer(&t);
+	while (t.fn && !(current->signal & ~(_BLOCKABLE & current->blocked))) {
+		current->state = TASK_INTERRUPTIBLE;
+		schedule();
+	}
+	sti();
+	if (!t.fn)
+		return 0;
+	del_hrtimer(&t);
+	if (rmtp) {
+		now = get_cycles();
+		now = (t.expires > now) ? t.expires - now : 0;
+		__asm__("divl %4"
+			:"=a" (sec),"=d" (rem)
+			:"0" ((unsigned long) now),"1" ((unsigned long) (now >> 32)),
+			 "r" (CLOCK_TICK_RATE));
+		verify_area(rmtp,sizeof(*rmtp));
+		put_fs_long(sec,(unsigned long *) &rmtp->tv_sec);
+		put_fs_long((rem * 3599597123653ULL) >> 32,
+			(unsigned long *) &rmtp->tv_nsec);
+	}
+	return -EINTR;
+}
+
 // 取当前进程号pid
 int sys_getpid(void)
 {
@@ -550,47 +1107,41 @@ int sys_nice(long increment)
 // 内核调度程序的初始化子程序
 void sched_init(void)
 {
-	int i;
-	struct desc_struct * p;                 // 描述符表结构指针
-
     // Linux系统开发之初，内核不成熟。内核代码会被经常修改。Linus怕自己无意中修改了
     // 这些关键性的数据结构，造成与POSIX标准的不兼容。这里加入下面这个判断语句并无
     // 必要，纯粹是为了提醒自己以及其他修改内核代码的人。
 	if (sizeof(struct sigaction) != 16)         // sigaction 是存放有关信号状态的结构
 		panic("Struct sigaction MUST be 16 bytes");
-    // 在全局描述符表中设置初始任务(任务0)的任务状态段描述符和局部数据表描述符。
-    // FIRST_TSS_ENTRY和FIRST_LDT_ENTRY的值分别是4和5，定义在include/linux/sched.h
-    // 中；gdt是一个描述符表数组(include/linux/head.h)，实际上对应程序head.s中
-    // 全局描述符表基址（_gdt）.因此gtd+FIRST_TSS_ENTRY即为gdt[FIRST_TSS_ENTRY](即为gdt[4]),
-    // 也即gdt数组第4项的地址。
-	set_tss_desc(gdt+FIRST_TSS_ENTRY,&(init_task.task.tss));
-	set_ldt_desc(gdt+FIRST_LDT_ENTRY,&(init_task.task.ldt));
-    // 清任务数组和描述符表项(注意 i=1 开始，所以初始任务的描述符还在)。描述符项结构
-    // 定义在文件include/linux/head.h中。
-	p = gdt+2+FIRST_TSS_ENTRY;
-	for(i=1;i<NR_TASKS;i++) {
-		task[i] = NULL;
-		p->a=p->b=0;
-		p++;
-		p->a=p->b=0;
-		p++;
-	}
+    // 在全局描述符表中设置唯一的任务状态段描述符和局部描述符表描述符(TSS_ENTRY和
+    // LDT_ENTRY分别是4和5，见include/linux/sched.h)。CPU只从TSS中取内核栈ss0:esp0，
+    // 它随任务切换由switch_to()更新；LDT描述符则每次切换时指向新任务的ldt[]。
+	tss.esp0 = init_task.task.thread.esp0;
+	tss.ss0 = 0x10;
+	tss.trace_bitmap = 0x80000000;		/* no i/o bitmap */
+	set_tss_desc(gdt+TSS_ENTRY,&tss);
+	set_ldt_desc(gdt+LDT_ENTRY,&(init_task.task.ldt));
 /* Clear NT, so that we won't have troubles with that later on */
     // NT标志用于控制程序的递归调用(Nested Task)。当NT置位时，那么当前中断任务执行
     // iret指令时就会引起任务切换。NT指出TSS中的back_link字段是否有效。
 	__asm__("pushfl ; andl $0xffffbfff,(%esp) ; popfl");        // 复位NT标志
-	ltr(0);
-	lldt(0);
-    // 下面代码用于初始化8253定时器。通道0，选择工作方式3，二进制计数方式。通道0的
-    // 输出引脚接在中断控制主芯片的IRQ0上，它每10毫秒发出一个IRQ0请求。LATCH是初始
-    // 定时计数值。
-	outb_p(0x36,0x43);		/* binary, mode 3, LSB/MSB, ch 0 */
-	outb_p(LATCH & 0xff , 0x40);	/* LSB */
-	outb(LATCH >> 8 , 0x40);	/* MSB */
+	ltr();
+	lldt();
+    // 下面代码用于初始化8253定时器。通道0，选择工作方式0(单次计数)，二进制计数方式。
+    // 通道0的输出引脚接在中断控制主芯片的IRQ0上，计到0时发出一个IRQ0请求。第一次定时
+    // 为一个滴答，以后每次中断时由do_timer()重新设定。
+	pit_program(LATCH);
     // 设置时钟中断处理程序句柄(设置时钟中断门)。修改中断控制器屏蔽码，允许时钟中断。
     // 然后设置系统调用中断门。这两个设置中断描述符表IDT中描述符在宏定义在文件
     // include/asm/system.h中。
 	set_intr_gate(0x20,&timer_interrupt);
 	outb(inb_p(0x21)&~0x01,0x21);
 	set_system_gate(0x80,&system_call);
+    // cpu支持sysenter时(cpuid的SEP位)，设置其入口所用的内核代码段、临时栈和入口地址。
+    // 早期的Pentium Pro(family 6，model和stepping都小于3)报告有SEP，实际并不支持。
+	if ((x86_capability & 0x800) &&			/* SEP */
+	    !(x86 == 6 && x86_model < 3 && x86_mask < 3)) {
+		wrmsr(0x174,0x08,0);			/* SYSENTER_CS */
+		wrmsr(0x175,(long) &sysenter_stack,0);	/* SYSENTER_ESP */
+		wrmsr(0x176,(long) sysenter_entry,0);	/* SYSENTER_EIP */
+	}
 }
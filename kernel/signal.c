@@ -4,6 +4,8 @@
  *  (C) 1991  Linus Torvalds
  */
 
+#include <errno.h>
+
 #include <linux/sched.h>
 #include <linux/kernel.h>
 #include <asm/segment.h>
@@ -106,6 +108,73 @@ int sys_sigaction(int signum, const struct sigaction * action,
 	return 0;
 }
 
+/*
+ * Make signal 'sig' pending for p. A real-time signal is also put at
+ * the end of p's queue together with its value; its bit stays set as
+ * long as one is queued. Permissions are the caller's business.
+ */
+// 向任务p发送信号sig。实时信号还要连同附带的值一起排入p的信号队列尾，
+// 只要队列中还有该信号，其位图中的对应位就保持置位。
+int queue_signal(struct task_struct * p, int sig, long value)
+{
+	if (sig < SIGRTMIN) {
+		p->signal |= (1<<(sig-1));
+		return 0;
+	}
+	if (p->sigq_nr >= NR_SIGQUEUE)
+		return -EAGAIN;
+	p->sigq[p->sigq_nr].sig = sig;
+	p->sigq[p->sigq_nr].value = value;
+	p->sigq_nr++;
+	p->signal |= (1<<(sig-1));
+	return 0;
+}
+
+/*
+ * Take the oldest instance of real-time signal 'sig' off the current
+ * queue and return its value. ret_from_sys_call has cleared the bit
+ * already: set it again if more of them are waiting.
+ */
+// 从当前任务的信号队列中取出最早的一个sig信号，返回其附带的值。
+static long dequeue_signal(int sig)
+{
+	struct sigq_entry * q = current->sigq;
+	struct sigq_entry * end = q + current->sigq_nr;
+	long value = 0;
+
+	for ( ; q < end ; q++)
+		if (q->sig == sig)
+			break;
+	if (q == end)
+		return 0;
+	value = q->value;
+	for (end-- ; q < end ; q++)
+		*q = *(q+1);
+	current->sigq_nr--;
+	for (q = current->sigq ; q < end ; q++)
+		if (q->sig == sig) {
+			current->signal |= (1<<(sig-1));
+			break;
+		}
+	return value;
+}
+
+// 系统调用sigqueue()：向进程pid发送信号sig并附带值value。
+int sys_sigqueue(int pid, int sig, long value)
+{
+	struct task_struct * p;
+
+	if (sig<0 || sig>32)
+		return -EINVAL;
+	if (pid <= 0 || !(p = find_task_by_pid(pid)))
+		return -ESRCH;
+	if (current->euid != p->euid && !suser())
+		return -EPERM;
+	if (!sig)
+		return 0;
+	return queue_signal(p,sig,value);
+}
+
 // 系统调用的中断处理程序中真正的信号预处理程序。
 // 该段代码的主要作用是将信号处理句柄插入到用户程序堆栈中，并在本系统调用结束
 // 返回后立即执行信号句柄程序，然后继续执行用户的程序。这个函数处理比较粗略，
@@ -126,6 +195,11 @@ void do_signal(long signr,long eax, long ebx, long ecx, long edx,
 	struct sigaction * sa = current->sigaction + signr - 1;
 	int longs;                          // 即current->sigaction[signr-1]
 	unsigned long * tmp_esp;
+	long value = 0;
+
+    // 实时信号先出队(即使被忽略)，取得其附带的值。
+	if (signr >= SIGRTMIN)
+		value = dequeue_signal(signr);
 
     // 如果信号句柄为SIG_IGN(1,默认忽略句柄)则不对信号进行处理而直接返回；
     // 如果句柄为SIG_DFL(0,默认处理)，则如果信号是SIGCHLD也直接返回，否则
@@ -165,6 +239,8 @@ void do_signal(long signr,long eax, long ebx, long ecx, long edx,
     // 如果允许信号自己的处理句柄程序收到信号自己，则也需要将进程的信号阻塞码压入堆栈。
 	*(&eip) = sa_handler;
 	longs = (sa->sa_flags & SA_NOMASK)?7:8;
+	if (sa->sa_flags & SA_SIGINFO)      // 句柄的第2个参数是信号附带的值
+		longs++;
     // 将原调用程序的用户堆栈指针向下扩展7(8)个字长(用来存放调用信号句柄的参数等)，
     // 并检查内存使用情况(例如如果内存超界则分配新页等)
 	*(&esp) -= longs;
@@ -174,6 +250,8 @@ void do_signal(long signr,long eax, long ebx, long ecx, long edx,
 	tmp_esp=esp;
 	put_fs_long((long) sa->sa_restorer,tmp_esp++);
 	put_fs_long(signr,tmp_esp++);
+	if (sa->sa_flags & SA_SIGINFO)
+		put_fs_long(value,tmp_esp++);
 	if (!(sa->sa_flags & SA_NOMASK))
 		put_fs_long(current->blocked,tmp_esp++);
 	put_fs_long(eax,tmp_esp++);
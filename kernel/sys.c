@@ -12,6 +12,7 @@
 #include <asm/segment.h>
 #include <sys/times.h>
 #include <sys/utsname.h>
+#include <sys/resource.h>
 
 // 返回日期和时间
 // 以下返回值是-ENOSYS的系统调用函数均表示在本版本内核中还未实现。
@@ -159,6 +160,7 @@ int sys_setreuid(int ruid, int euid)
 			return(-EPERM);
 		}
 	}
+	sched_regroup(current);
 	return 0;
 }
 
@@ -207,7 +209,9 @@ int sys_brk(unsigned long end_data_seg)
 {
     // 如果参数值大于代码结尾，并且小于(堆栈 - 16KB)，则设置新数据段结尾值
 	if (end_data_seg >= current->end_code &&
-	    end_data_seg < current->start_stack - 16384)
+	    end_data_seg < current->start_stack - 16384 &&
+	    end_data_seg - current->end_code <=
+	    current->rlim[RLIMIT_DATA].rlim_cur)
 		current->brk = end_data_seg;
 	return current->brk;                // 返回进程当前的数据段结尾值
 }
@@ -225,7 +229,7 @@ int sys_brk(unsigned long end_data_seg)
 // 加入进程的相同。
 int sys_setpgid(int pid, int pgid)
 {
-	int i;
+	struct task_struct * p;
 
     // 如果参数pid=0,则使用当前进程号。如果pgid＝0，则使用当前进程Pid作为pgid。
     // 【？？这里与POSIX标准的描述有出入】
@@ -233,20 +237,18 @@ int sys_setpgid(int pid, int pgid)
 		pid = current->pid;
 	if (!pgid)
 		pgid = current->pid;
-    // 扫描任务数组，查找指定进程号pid的任务。如果找到了进程号是pid的进程，
-    // 那么若该任务已经是回话首领，则出错返回。若该任务的会话ID与当前进程
-    // 的不同，则也出错返回。否则设置进程的pgrp = pgid,并返回0.若没有找到
-    // 指定pid的进程，则返回进程不存在出错码。
-	for (i=0 ; i<NR_TASKS ; i++)
-		if (task[i] && task[i]->pid==pid) {
-			if (task[i]->leader)
-				return -EPERM;
-			if (task[i]->session != current->session)
-				return -EPERM;
-			task[i]->pgrp = pgid;
-			return 0;
-		}
-	return -ESRCH;
+    // 查找指定进程号pid的任务。若没有找到，则返回进程不存在出错码。如果该
+    // 任务已经是会话首领，则出错返回。若该任务的会话ID与当前进程的不同，
+    // 则也出错返回。否则设置进程的pgrp = pgid,并返回0.
+	if (!(p = find_task_by_pid(pid)))
+		return -ESRCH;
+	if (p->leader)
+		return -EPERM;
+	if (p->session != current->session)
+		return -EPERM;
+	p->pgrp = pgid;
+	sched_regroup(p);
+	return 0;
 }
 
 // 返回当前进程的进程组号。与getpgid(0)等同。
@@ -267,6 +269,7 @@ int sys_setsid(void)
 	current->leader = 1;
 	current->session = current->pgrp = current->pid;
 	current->tty = -1;              // 表示当前进程没有控制终端。
+	sched_regroup(current);
 	return current->pgrp;
 }
 
@@ -290,6 +293,38 @@ int sys_uname(struct utsname * name)
 	return 0;
 }
 
+int sys_getrlimit(int resource, struct rlimit * rlim)
+{
+	if (resource < 0 || resource >= RLIM_NLIMITS)
+		return -EINVAL;
+	verify_area(rlim,sizeof *rlim);
+	put_fs_long(current->rlim[resource].rlim_cur,
+		(unsigned long *) &rlim->rlim_cur);
+	put_fs_long(current->rlim[resource].rlim_max,
+		(unsigned long *) &rlim->rlim_max);
+	return 0;
+}
+
+/*
+ * Anybody may lower a limit, but only root may raise the hard limit.
+ */
+int sys_setrlimit(int resource, struct rlimit * rlim)
+{
+	struct rlimit new, *old;
+
+	if (resource < 0 || resource >= RLIM_NLIMITS)
+		return -EINVAL;
+	old = current->rlim + resource;
+	new.rlim_cur = get_fs_long((unsigned long *) &rlim->rlim_cur);
+	new.rlim_max = get_fs_long((unsigned long *) &rlim->rlim_max);
+	if (new.rlim_cur < 0 || new.rlim_cur > new.rlim_max)
+		return -EINVAL;
+	if (new.rlim_max > old->rlim_max && !suser())
+		return -EPERM;
+	*old = new;
+	return 0;
+}
+
 // 设置当前进程创建文件属性屏蔽码为mask & 0777。并返回原屏蔽码。
 int sys_umask(int mask)
 {
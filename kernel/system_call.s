@@ -65,28 +65,103 @@ sa_mask = 4                 # 信号屏蔽码
 sa_flags = 8                # 信号集
 sa_restorer = 12            # 恢复函数指针
 
-nr_system_calls = 72        # Linux 0.11 版本内核中的系统共调用总数。
+nr_system_calls = 84        # Linux 0.11 版本内核中的系统共调用总数。
 
 /*
  * Ok, I get parallel printer interrupts while using the floppy for some
  * strange reason. Urgel. Now I just ignore them.
  */
 # 定义入口点
-.globl system_call,sys_fork,timer_interrupt,sys_execve
+.globl system_call,sys_fork,timer_interrupt,sys_execve,ret_from_fork
 .globl hd_interrupt,floppy_interrupt,parallel_interrupt
 .globl device_not_available, coprocessor_error
+.globl preempt_check
+.globl sysenter_entry,sysenter_stack
 
 # 错误的系统调用号
 .align 2                # 内存4字节对齐
 bad_sys_call:
 	movl $-1,%eax       # eax 中置-1，退出中断
 	iret
+# 硬件中断处理程序退出前调用，栈顶参数是被中断代码的cs。如果处理程序唤醒了比当前
+# 任务优先级高的实时任务(need_resched)，并且将返回用户态，则立即调度。内核态不可抢占。
+.align 2
+preempt_check:
+	cmpl $0,need_resched
+	je 1f
+	testl $3,4(%esp)		# back to user mode?
+	je 1f
+	jmp schedule
+1:	ret
+# 系统调用跟踪打开时，在调用前后分别调用systrace_enter(nr)和systrace_exit(ret)，
+# 见kernel/systrace.c。参数仍留在栈上原来的位置，调用号在eax中。
+traced_call:
+	pushl %eax
+	call systrace_enter
+	popl %eax
+	call *sys_call_table(,%eax,4)
+	pushl %eax
+	call systrace_exit
+	popl %eax
+	jmp sys_call_done
+
+# sysenter进入时esp指向这个临时栈，入口处的第一条指令就换到内核栈。但在此之前仍可能
+# 来一个NMI，其处理过程(do_nmi、die、printk)就运行在这个栈上，所以要留够空间，并且
+# 不能放在代码段里。
+.data
+.align 4
+	.fill 256,4,0		# room for an NMI before the first instruction
+sysenter_stack:
+.text
+
 # 重新执行调度程序入口。调度程序schedule在sched.c中。
 # 当调度程序schedule返回时就从ret_from_sys_call出继续执行。
 .align 2
 reschedule:
 	pushl $ret_from_sys_call        # 将ret_from_sys_call返回地址压入堆栈
 	jmp schedule
+# sysenter快速入口。cpu此时已处于内核代码段0x08、堆栈段0x10，esp是一个临时小栈，
+# 中断已关闭。用户存根(见include/unistd.h)把自己的ebp和返回地址压在用户栈上，并把
+# 该栈顶指针放在ebp中。这里切换到当前任务的内核栈，构造与int 0x80完全相同的栈帧，
+# 然后与system_call共用调用表和返回路径。返回仍用iret：sysexit只能返回到基址为0的
+# 平坦段，而用户任务运行在基址为TASK_BASE的LDT段中。
+/*
+ * sysenter fast path. The user stub pushed its %ebp and the return
+ * address and left that stack pointer in %ebp. We build the same frame
+ * int 0x80 would have and share the dispatch and return path; the way
+ * back stays iret, as sysexit can only return to flat user segments.
+ */
+.align 2
+sysenter_entry:
+	movl tss+4,%esp		# the real kernel stack (esp0)
+	pushl $0x17		# old ss
+	pushl %ebp		# old esp, fixed up below
+	pushfl
+	orl $0x200,(%esp)	# sysenter cleared IF
+	pushl $0x0f		# old cs
+	pushl $0		# old eip, fixed up below
+	push %ds
+	push %es
+	push %fs
+	pushl %edx
+	pushl %ecx
+	pushl %ebx
+	movl $0x10,%edx
+	mov %dx,%ds
+	mov %dx,%es
+	movl $0x17,%edx
+	mov %dx,%fs
+	sti
+	movl %fs:(%ebp),%edx		# return address left by the stub
+	movl %edx,EIP-4(%esp)
+	addl $8,OLDESP-4(%esp)		# user esp after the stub's two words
+	movl %fs:4(%ebp),%ebp		# and the stub's own %ebp
+	movl EDX-4(%esp),%edx		# %edx was clobbered above
+	cmpl $nr_system_calls-1,%eax
+	jbe sys_call_dispatch
+	pushl $-1
+	jmp ret_from_sys_call
+
 ### int 0x80 - linux系统调用入口点(调用中断int 0x80,eax 中是调用号)
 .align 2
 system_call:
@@ -112,12 +187,18 @@ system_call:
 # 下面这句操作数的含义是：调用地址=[_sys_call_table + %eax * 4]
 # sys_call_table[]是一个指针数组，定义在include/linux/sys.h中，该指针数组中设置了所有72
 # 个系统调用C处理函数地址。
+sys_call_dispatch:
+	cmpl $0,systrace_on		# tracing system calls?
+	jne traced_call
 	call sys_call_table(,%eax,4)        # 间接调用指定功能C函数
+sys_call_done:
 	pushl %eax                          # 把系统调用返回值入栈
 # 下面几行查看当前任务的运行状态。如果不在就绪状态(state != 0)就去执行调度程序。如果该
 # 任务在就绪状态，但其时间片已用完(counter = 0),则也去执行调度程序。例如当后台进程组中的
 # 进程执行控制终端读写操作时，那么默认条件下该后台进程组所有进程会收到SIGTTIN或SIGTTOU
 # 信号，导致进程组中所有进程处于停止状态。而当前进程则会立刻返回。
+	cmpl $0,need_resched		# a real-time task woke up?
+	jne reschedule
 	movl current,%eax                   # 取当前任务(进程)数据结构地址→eax
 	cmpl $0,state(%eax)		# state
 	jne reschedule
@@ -128,7 +209,7 @@ system_call:
 ret_from_sys_call:
 # 首先判别当前任务是否是初始任务task0,如果是则不对其进行信号量方面的处理，直接返回。
 	movl current,%eax		# task[0] cannot have signals
-	cmpl task,%eax
+	cmpl $init_task,%eax
 	je 3f                   # 向前(forward)跳转到标号3处退出中断处理
 # 通过对原调用程序代码选择符的检查来判断调用程序是否是用户任务。如果不是则直接退出中断。
 # 这是因为任务在内核态执行时不可抢占。否则对任务进行信号量的识别处理。这里比较选择符是否
@@ -224,10 +305,11 @@ device_not_available:
 	popl %ebp
 	ret
 
-### int32 - (int 0x20)时钟中断处理程序。中断频率被设置为100Hz。
-# 定时芯片8253/8254是在kernel/sched.c中初始化的。因此这里jiffies每10 ms加1.
-# 这段代码将jiffies增1，发送结束中断指令给8259控制器，然后用当前特权级作为
-# 参数调用C函数do_timer(long CPL).当调用返回时转去检测并处理信号。
+### int32 - (int 0x20)时钟中断处理程序。系统忙时每10ms一次，空闲时按需产生。
+# 定时芯片8253/8254是在kernel/sched.c中初始化的，工作于单次计数方式，由do_timer()
+# 每次重新设定下一个事件，jiffies也由它根据经过的时钟周期更新。这段代码发送结束中断
+# 指令给8259控制器，然后用当前特权级作为参数调用C函数do_timer(long CPL).当调用返回
+# 时转去检测并处理信号。
 .align 2
 timer_interrupt:
 	push %ds		# save ds,es and put kernel data space
@@ -242,7 +324,6 @@ timer_interrupt:
 	mov %ax,%es
 	movl $0x17,%eax
 	mov %ax,%fs
-	incl jiffies
 # 由于初始化中断控制芯片时没有采用自动EOI，所以这里需要发指令结束该硬件中断。
 	movb $0x20,%al		# EOI to interrupt controller #1
 	outb %al,$0x20      # 操作命令字OCW2送0x20端口
@@ -281,6 +362,20 @@ sys_fork:
 	addl $20,%esp               # 丢弃这里所有压栈内容。
 1:	ret
 
+# A new child starts here, on the stack copy_process() built for it: the
+# callee-saved registers and gs first, then an ordinary system call frame.
+# fs still holds the parent's LDT descriptor, so reload it before
+# ret_from_sys_call gets a chance to deliver a signal through it.
+.align 2
+ret_from_fork:
+	popl %edi
+	popl %esi
+	popl %ebp
+	pop %gs
+	movl $0x17,%eax
+	mov %ax,%fs
+	jmp ret_from_sys_call
+
 ### int46 - (int 0x2e)硬盘中断处理程序，响应硬件中断请求IRQ4。
 # 当请求的硬盘操作完成或出错就会发出此中断信号。
 # 首先向8259A中断控制从芯片发送结束硬件中断指令(EOI),然后取变量do_hd中的函数指针
@@ -314,6 +409,9 @@ hd_interrupt:
 	movl $unexpected_hd_interrupt,%edx
 1:	outb %al,$0x20              # 送主8259A中断控制器EOI命令(结束硬件中断)
 	call *%edx		# "interesting" way of handling intr.
+	pushl 28(%esp)		# old cs
+	call preempt_check
+	addl $4,%esp
 	pop %fs                     # 上句调用do_hd指向C函数
 	pop %es
 	pop %ds
@@ -349,6 +447,9 @@ floppy_interrupt:
 	jne 1f
 	movl $unexpected_floppy_interrupt,%eax
 1:	call *%eax		# "interesting" way of handling intr.
+	pushl 28(%esp)		# old cs
+	call preempt_check
+	addl $4,%esp
 	pop %fs
 	pop %es
 	pop %ds
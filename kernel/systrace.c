@@ -0,0 +1,136 @@
+/*
+ *  linux/kernel/systrace.c
+ *
+ *  (C) 1991  Linus Torvalds
+ */
+
+/*
+ * System call tracing. system_call.s calls systrace_enter() and
+ * systrace_exit() around the sys_call_table dispatch when systrace_on
+ * is set, so the untraced path costs one compare.
+ */
+#include <errno.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <asm/system.h>
+#include <asm/segment.h>
+#include <sys/systrace.h>
+
+#define NR_TRACE	256		/* records in the ring buffer */
+
+// 跟踪开关(system_call.s中测试)，被跟踪进程的pid(0表示全部进程)。
+long systrace_on = 0;
+static long systrace_pid = 0;
+
+// 环形缓冲区：trace_head是下一条记录写入的位置，trace_tail是最早的未读记录。
+// 缓冲区满时覆盖最早的记录。
+static struct systrace_rec trace_buf[NR_TRACE];
+static unsigned long trace_head = 0, trace_tail = 0;
+static struct systrace_stat trace_stat[ST_NR_CALLS];
+
+// 系统调用入口，记下调用号和开始时刻。不跟踪的进程trace_nr置为-1。
+void systrace_enter(long nr)
+{
+	if (systrace_pid && current->pid != systrace_pid) {
+		current->trace_nr = -1;
+		return;
+	}
+	current->trace_nr = nr;
+	current->trace_start = get_cycles();
+}
+
+// 系统调用返回前，写入一条记录并累计该调用号的次数和延迟。
+void systrace_exit(long ret)
+{
+	struct systrace_rec * r;
+	struct systrace_stat * s;
+	unsigned long lat;
+	long nr = current->trace_nr;
+
+	if (nr < 0)
+		return;
+	current->trace_nr = -1;
+	lat = get_cycles() - current->trace_start;
+	cli();
+	r = trace_buf + trace_head % NR_TRACE;
+	r->pid = current->pid;
+	r->nr = nr;
+	r->ret = ret;
+	r->start = current->trace_start;
+	r->lat = lat;
+	if (++trace_head - trace_tail > NR_TRACE)
+		trace_tail++;
+	if (nr < ST_NR_CALLS) {
+		s = trace_stat + nr;
+		s->count++;
+		s->total += lat;
+		if (lat > s->max)
+			s->max = lat;
+	}
+	sti();
+}
+
+// 复制n个长字到用户空间
+static void put_fs_longs(unsigned long * from, unsigned long * to, int n)
+{
+	while (n-- > 0)
+		put_fs_long(*from++,to++);
+}
+
+// 系统调用 - 控制和读取系统调用跟踪，见<sys/systrace.h>。
+int sys_systrace(int cmd, long arg, void * buf)
+{
+	struct task_struct * p;
+	struct systrace_rec r;
+	int i;
+
+	if (!suser())
+		return -EPERM;
+	switch (cmd) {
+		case ST_OFF:
+			systrace_on = 0;
+			return 0;
+		case ST_ON:
+			for_each_task(p)
+				p->trace_nr = -1;
+			systrace_pid = arg;
+			systrace_on = 1;
+			return 0;
+		case ST_READ:
+			if (arg < 0)
+				return -EINVAL;
+			if (arg > NR_TRACE)		/* no more than the ring holds */
+				arg = NR_TRACE;
+			verify_area(buf,arg * sizeof(r));
+			for (i = 0 ; i < arg ; i++) {
+				cli();
+				if (trace_tail == trace_head) {
+					sti();
+					break;
+				}
+				r = trace_buf[trace_tail++ % NR_TRACE];
+				sti();
+				put_fs_longs((unsigned long *) &r,
+					i * sizeof(r) / 4 + (unsigned long *) buf,
+					sizeof(r) / 4);
+			}
+			return i;
+		case ST_STATS:
+			if (arg < 0 || arg > ST_NR_CALLS)
+				return -EINVAL;
+			verify_area(buf,arg * sizeof(struct systrace_stat));
+			put_fs_longs((unsigned long *) trace_stat,buf,
+				arg * sizeof(struct systrace_stat) / 4);
+			return arg;
+		case ST_RESET:
+			cli();
+			trace_head = trace_tail = 0;
+			for (i = 0 ; i < ST_NR_CALLS ; i++)
+				trace_stat[i].count = trace_stat[i].total =
+					trace_stat[i].max = 0;
+			sti();
+			return 0;
+	}
+	return -EINVAL;
+}
@@ -0,0 +1,28 @@
+/*
+ *  linux/lib/select.c
+ *
+ *  (C) 1991  Linus Torvalds
+ */
+
+#define __LIBRARY__
+#include <unistd.h>
+#include <sys/time.h>
+
+/*
+ * The system call takes a pointer to its five arguments, which are
+ * conveniently lined up on our stack already.
+ */
+int select(int nfds, fd_set * readfds, fd_set * writefds,
+	fd_set * exceptfds, struct timeval * timeout)
+{
+	register int res;
+
+	__asm__ volatile ("int $0x80"
+		:"=a" (res)
+		:"0" (__NR_select),"b" (&nfds)
+		:"memory");
+	if (res>=0)
+		return res;
+	errno = -res;
+	return -1;
+}
@@ -0,0 +1,34 @@
+/*
+ *  linux/lib/sigrestore.c
+ *
+ *  (C) 1991  Linus Torvalds
+ */
+
+#define __LIBRARY__
+#include <unistd.h>
+
+#define __str(x) #x
+#define str(x) __str(x)
+
+/*
+ * Restorers for handlers set with SA_SIGINFO. do_signal() leaves the
+ * restorer, the signal number, the value, the old blocked mask (unless
+ * SA_NOMASK), eax, ecx, edx, eflags and eip on the user stack; the
+ * handler returns here with %esp at the signal number. The old mask is
+ * swapped with %ebx for the ssetmask call, so no register is lost.
+ */
+__asm__(".globl __siginfo_restore,__siginfo_nomask_restore\n"
+	"__siginfo_restore:\n\t"
+	"addl $8,%esp\n\t"		/* signal number and value */
+	"xchgl %ebx,(%esp)\n\t"		/* old mask */
+	"movl $" str(__NR_ssetmask) ",%eax\n\t"
+	"int $0x80\n\t"
+	"popl %ebx\n\t"
+	"jmp 1f\n"
+	"__siginfo_nomask_restore:\n\t"
+	"addl $8,%esp\n"
+	"1:\tpopl %eax\n\t"
+	"popl %ecx\n\t"
+	"popl %edx\n\t"
+	"popfl\n\t"
+	"ret");
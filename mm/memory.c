@@ -41,12 +41,53 @@ static inline volatile void oom(void)
 	do_exit(SIGSEGV);
 }
 
+/*
+ * check_rss() is called before a fault gives the current task another
+ * page of its own. There is no swapping, so a task that has gone over
+ * its RLIMIT_RSS can only be killed.
+ */
+static inline void check_rss(void)
+{
+	if (current->rss >= (current->rlim[RLIMIT_RSS].rlim_cur >> 12)) {
+		printk("rss limit exceeded\n\r");
+		do_exit(SIGSEGV);
+	}
+}
+
 // 刷新页变换高速缓冲宏函数。
 // 为了提高地址转换的效率，CPU将最近使用的页表数据存放在芯片中高速缓冲中。在修
 // 改过页表信息之后，就需要刷新该缓冲区。这里使用重新加载页目录基地址寄存器cr3
 // 的方法来进行刷新。下面eax=0,是页目录的基址。
 #define invalidate() \
-__asm__("movl %%eax,%%cr3"::"a" (0))
+__asm__("movl %%eax,%%cr3"::"a" (current->thread.cr3))
+
+/*
+ * Every task has its own page directory (thread.cr3, see new_page_dir()),
+ * all sharing the kernel's page tables below TASK_BASE. Page directories
+ * and page tables are below 16Mb, so physical == linear for them.
+ */
+#define dir_entry(dir,addr) \
+((unsigned long *) ((dir) + (((addr)>>20) & 0xffc)))
+#define cur_dir_entry(addr) dir_entry(current->thread.cr3,addr)
+
+/*
+ * invalidate_page() throws out just the one TLB entry for a linear
+ * address. invlpg is a 486 instruction, so a 386 still has to reload
+ * cr3. Global kernel pages (see head.s) survive both.
+ */
+static inline void invalidate_page(unsigned long addr)
+{
+	if (x86 > 3)
+		__asm__("invlpg %0"::"m" (*(char *) addr));
+	else
+		invalidate();
+}
+
+/*
+ * Past this many pages it's cheaper to flush the whole TLB than to
+ * keep doing invlpg's.
+ */
+#define INVLPG_MAX 32
 
 /* these are not to be changed without changing head.s etc */
 // linux0.11内核默认支持的最大内存容量是16MB，可以修改这些定义适合更多的内存。
@@ -78,6 +119,23 @@ __asm__("cld ; rep ; movsl"::"S" (from),"D" (to),"c" (1024))
 // 不能用做主内存页面的位置均都预先被设置成USED（100）.
 static unsigned char mem_map [ PAGING_PAGES ] = {0,};
 
+/*
+ * The zero page lives in head.s, below LOW_MEM, so it is never counted
+ * in mem_map: free_page() and copy_page_tables() leave it alone, and
+ * un_wp_page() always gives the writer a private copy.
+ */
+extern char empty_zero_page[PAGE_SIZE];
+#define ZERO_PAGE ((unsigned long) empty_zero_page)
+
+/*
+ * Pages cleared by the idle task (see zero_idle_page()). They are
+ * already marked used in mem_map, and get_free_page() hands them out
+ * before it goes looking for a page it has to clear itself.
+ */
+#define NR_ZEROED_PAGES 32
+static unsigned long zeroed_pages[NR_ZEROED_PAGES];
+static int nr_zeroed_pages = 0;
+
 /*
  * Get physical address of first (actually last :-) free page, and mark it
  * used. If no free pages left, return 0.
@@ -92,7 +150,7 @@ static unsigned char mem_map [ PAGING_PAGES ] = {0,};
 // 并没有映射到某个进程的地址空间中去。后面的put_page()函数即用于把指定页面映射
 // 到某个进程地址空间中。当然对于内核使用本函数并不需要再使用put_page()进行映射，
 // 因为内核代码和数据空间（16MB）已经对等地映射到物理地址空间。
-unsigned long get_free_page(void)
+static unsigned long find_free_page(void)
 {
 register unsigned long __res asm("ax");
 
@@ -114,6 +172,59 @@ __asm__("std ; repne ; scasb\n\t"   // 置方向位，al(0)与对应每个页面
 return __res;           // 返回空闲物理页面地址(若无空闲页面则返回0).
 }
 
+unsigned long get_free_page(void)
+{
+	if (nr_zeroed_pages)
+		return zeroed_pages[--nr_zeroed_pages];
+	return find_free_page();
+}
+
+/*
+ * Get 1<<order physically contiguous pages, for the few users that
+ * need more than one page (large tty queues). Unlike get_free_page()
+ * the pages are not cleared. Returns 0 if there is no such block.
+ */
+unsigned long get_free_pages(int order)
+{
+	int i, j, n = 1 << order;
+
+	if (!order)
+		return get_free_page();
+	for (i = PAGING_PAGES - n ; i >= 0 ; i -= n) {
+		for (j = 0 ; j < n && !mem_map[i+j] ; j++)
+			;
+		if (j < n)
+			continue;
+		for (j = 0 ; j < n ; j++)
+			mem_map[i+j] = 1;
+		return LOW_MEM + (i << 12);
+	}
+	return 0;
+}
+
+void free_pages(unsigned long addr, int order)
+{
+	int n = 1 << order;
+
+	while (n--)
+		free_page(addr + (n << 12));
+}
+
+/*
+ * zero_idle_page() is called by the idle task each time round its
+ * loop. It clears one page per call, so that an interrupt waking up
+ * somebody never has to wait for more than a single page clear.
+ */
+void zero_idle_page(void)
+{
+	unsigned long page;
+
+	if (nr_zeroed_pages >= NR_ZEROED_PAGES)
+		return;
+	if ((page = find_free_page()))
+		zeroed_pages[nr_zeroed_pages++] = page;
+}
+
 /*
  * Free a page of memory at physical address 'addr'. Used by
  * 'free_page_tables()'
@@ -152,10 +263,12 @@ void free_page(unsigned long addr)
 // 程0和1）的页表所占据的页面在进程被创建时由内核为其主内存区申请得到。每个页表
 // 项对应1耶物理内存，因此一个页表最多可映射4MB的物理内存。
 // 参数：from - 起始线性基地址；size - 释放的字节长度。
-int free_page_tables(unsigned long from,unsigned long size)
+static int free_dir_tables(unsigned long pgd,unsigned long from,
+	unsigned long size)
 {
 	unsigned long *pg_table;
 	unsigned long * dir, nr;
+	int flushes = 0;
 
     // 首先检测参数from给出的线性基地址是否在4MB的边界处。因为该函数只能处理这
     // 种情况。若from=0,则出错。说明视图释放内核和缓冲所占空间。
@@ -172,7 +285,7 @@ int free_page_tables(unsigned long from,unsigned long size)
     // 项号<<2，也即(from>>20)。& 0xffc确保目录项指针范围有效，即用于屏蔽目录项
     // 指针最后2位。因为只移动了20位，因此最后2位是页表项索引的内容，应屏蔽掉。
 	size = (size + 0x3fffff) >> 22;
-	dir = (unsigned long *) ((from>>20) & 0xffc); /* _pg_dir = 0 */
+	dir = dir_entry(pgd,from);
     // 此时size是释放的页表个数，即页目录项数，而dir是起始目录项指针。现在开始
     // 循环操作页目录项，依次释放每个页表中的页表项。如果当前目录项无效（P位＝0）
     // 表示该目录项没有使用(对应的页表不存在)，则继续处理下一个目录项。否则从目
@@ -180,23 +293,64 @@ int free_page_tables(unsigned long from,unsigned long size)
     // 表项(P位＝1)对应的物理内存页表。然后该页表项清零，并继续处理下一页表项。
     // 当一个页表所有表项都处理完毕就释放该页表自身占据的内存页面，并继续处理下
     // 一页目录项。最后刷新也页变换高速缓冲，并返回0.
-	for ( ; size-->0 ; dir++) {
+	for ( ; size-->0 ; dir++,from += 0x400000) {
 		if (!(1 & *dir))
 			continue;
 		pg_table = (unsigned long *) (0xfffff000 & *dir);  // 取页表地址
 		for (nr=0 ; nr<1024 ; nr++) {
-			if (1 & *pg_table)                          // 若该项有效，则释放对应页。 
+			if (1 & *pg_table) {                        // 若该项有效，则释放对应页。 
 				free_page(0xfffff000 & *pg_table);
-			*pg_table = 0;                              // 该页表项内容清零。
+				*pg_table = 0;                          // 该页表项内容清零。
+				if (++flushes <= INVLPG_MAX &&
+				    pgd == current->thread.cr3)
+					invalidate_page(from + (nr<<12));
+			}
 			pg_table++;                                 // 指向页表中下一项。
 		}
 		free_page(0xfffff000 & *dir);                   // 释放该页表所占内存页面。
 		*dir = 0;                                       // 对应页表的目录项清零
+    // 目录项也可能被cpu缓存着，而它指向的页表页面刚被释放。即使该页表中没有有效项，
+    // 也要在目录项清零之后对这4MB范围做一次invlpg。
+		if (++flushes <= INVLPG_MAX && pgd == current->thread.cr3)
+			invalidate_page(from);	/* the cached pde, too */
 	}
-	invalidate();                                       // 刷新页变换高速缓冲。
+	if (flushes > INVLPG_MAX && pgd == current->thread.cr3)
+		invalidate();                                   // 刷新页变换高速缓冲。
 	return 0;
 }
 
+int free_page_tables(unsigned long from,unsigned long size)
+{
+	return free_dir_tables(current->thread.cr3,from,size);
+}
+
+/*
+ * new_page_dir() gets a page directory for a new task, with the kernel
+ * mapped below TASK_BASE just as in pg_dir. Returns 0 if out of memory.
+ */
+unsigned long new_page_dir(void)
+{
+	unsigned long dir;
+	int i;
+
+	if (!(dir = get_free_page()))
+		return 0;
+	for (i = 0 ; i < (TASK_BASE>>22) ; i++)
+		((unsigned long *) dir)[i] = pg_dir[i];
+	return dir;
+}
+
+/*
+ * free_page_dir() undoes a fork that failed half way: the child never
+ * ran, so just drop whatever user page tables it got and the directory.
+ */
+void free_page_dir(struct task_struct * p)
+{
+	free_dir_tables(p->thread.cr3,TASK_BASE,TASK_SIZE);
+	free_page(p->thread.cr3);
+	p->thread.cr3 = 0;
+}
+
 /*
  *  Well, here is one of the most complicated functions in mm. It
  * copies a range of linerar addresses by copying only the pages.
@@ -213,6 +367,9 @@ int free_page_tables(unsigned long from,unsigned long size)
  * doesn't take any more memory - we don't copy-on-write in the low
  * 1 Mb-range, so the pages can be shared with the kernel. Thus the
  * special case for nr=xxxx.
+ *
+ * Returns the number of pages now shared copy-on-write, so that fork
+ * can set up the memory accounting, or -1 if out of memory.
  */
 //// 复制页目录表项和页表项
 // 复制指定线性地址和长度内存对应的页目录项和页表项，从而被复制的页目录和页表对
@@ -220,13 +377,15 @@ int free_page_tables(unsigned long from,unsigned long size)
 // 表，原物理内存区将被共享。此后两个进程（父进程和其子进程）将共享内存区，直到
 // 有一个进程执行谢操作时，内核才会为写操作进程分配新的内存页(写时复制机制)。
 // 参数from、to是线性地址，size是需要复制（共享）的内存长度，单位是byte.
-int copy_page_tables(unsigned long from,unsigned long to,long size)
+int copy_page_tables(unsigned long from,unsigned long to,long size,
+	struct task_struct * p)
 {
 	unsigned long * from_page_table;
 	unsigned long * to_page_table;
 	unsigned long this_page;
 	unsigned long * from_dir, * to_dir;
 	unsigned long nr;
+	int shared = 0;
 
     // 首先检测参数给出的原地址from和目的地址to的有效性。原地址和目的地址都需要
     // 在4Mb内存边界地址上。否则出错死机。作这样的要求是因为一个页表的1024项可
@@ -236,8 +395,8 @@ int copy_page_tables(unsigned long from,unsigned long to,long size)
     // 算要复制的内存块占用的页表数(即目录项数)。
 	if ((from&0x3fffff) || (to&0x3fffff))
 		panic("copy_page_tables called with wrong alignment");
-	from_dir = (unsigned long *) ((from>>20) & 0xffc); /* _pg_dir = 0 */
-	to_dir = (unsigned long *) ((to>>20) & 0xffc);
+	from_dir = cur_dir_entry(from);
+	to_dir = dir_entry(p->thread.cr3,to);
 	size = ((unsigned) (size+0x3fffff)) >> 22;
     // 在得到了源起始目录项指针from_dir和目的起始目录项指针to_dir以及需要复制的
     // 页表个数size后，下面开始对每个页目录项依次申请1页内存来保存对应的页表，并
@@ -292,18 +451,19 @@ int copy_page_tables(unsigned long from,unsigned long to,long size)
 				this_page -= LOW_MEM;
 				this_page >>= 12;
 				mem_map[this_page]++;
+				shared++;
 			}
 		}
 	}
 	invalidate();
-	return 0;
+	return shared;
 }
 
 /*
  * This function puts a page in memory at the wanted address.
  * It returns the physical address of the page gotten, 0 if
  * out of memory (either when trying to access page-table or
- * page.)
+ * page.) The page is charged to the current task's rss.
  */
 //// 把一物理内存页面映射到线性地址空间指定处。
 // 或者说是把线性地址空间中指定地址address出的页面映射到主内存区页面page上。主
@@ -317,8 +477,6 @@ unsigned long put_page(unsigned long page,unsigned long address)
 {
 	unsigned long tmp, *page_table;
 
-/* NOTE !!! This uses the fact that _pg_dir=0 */
-
     // 首先判断参数给定物理内存页面page的有效性。如果该页面位置低于LOW_MEM（1MB）
     // 或超出系统实际含有内存高端HIGH_MEMORY，则发出警告。LOW_MEM是主内存区可能
     // 有的最小起始位置。当系统物理内存小于或等于6MB时，主内存区起始于LOW_MEM处。
@@ -333,7 +491,7 @@ unsigned long put_page(unsigned long page,unsigned long address)
     // 取得指定页表地址放到page_table 变量中。否则就申请一空闲页面给页表使用，并
     // 在对应目录项中置相应标志(7 - User、U/S、R/W).然后将该页表地址放到page_table
     // 变量中。
-	page_table = (unsigned long *) ((address>>20) & 0xffc);
+	page_table = cur_dir_entry(address);
 	if ((*page_table)&1)
 		page_table = (unsigned long *) (0xfffff000 & *page_table);
 	else {
@@ -345,8 +503,14 @@ unsigned long put_page(unsigned long page,unsigned long address)
     // 最后在找到的页表page_table中设置相关页表内容，即把物理页面page的地址填入
     // 表项同时置位3个标志(U/S、W/R、P)。该页表项在页表中索引值等于线性地址位21
     // -- 位12组成的10bit的值。每个页表共可有1024项(0 -- 0x3ff)。
-	page_table[(address>>12) & 0x3ff] = page | 7;
-/* no need for invalidate */
+	page_table += (address>>12) & 0x3ff;
+	tmp = *page_table;
+	*page_table = page | 7;
+	if (!(tmp & 1) || (tmp & 0xfffff000) < LOW_MEM)
+		current->rss++;
+/* no need for invalidate unless something was mapped here before */
+	if (tmp & 1)
+		invalidate_page(address);
 	return page;
 }
 
@@ -358,7 +522,7 @@ unsigned long put_page(unsigned long page,unsigned long address)
 // 申请一新页面并复制被写页面内容，以供写进程单独使用。共享被取消。本函数供下面
 // do_wp_page()调用。
 // 输入参数为页表项指针，是物理地址。[up_wp_page -- Un-Write Protect Page]
-void un_wp_page(unsigned long * table_entry)
+void un_wp_page(unsigned long * table_entry, unsigned long address)
 {
 	unsigned long old_page,new_page;
 
@@ -371,7 +535,9 @@ void un_wp_page(unsigned long * table_entry)
 	old_page = 0xfffff000 & *table_entry;
 	if (old_page >= LOW_MEM && mem_map[MAP_NR(old_page)]==1) {
 		*table_entry |= 2;
-		invalidate();
+		invalidate_page(address);
+		if (current->shared > 0)	/* the other sharers are gone */
+			current->shared--;
 		return;
 	}
     // 否则就需要在主内存区申请一页空闲页面给执行写操作的进程单独使用，取消页面
@@ -379,13 +545,20 @@ void un_wp_page(unsigned long * table_entry)
     // 面的页面映射字节数组递减1。然后将指定页表项内容更新为新页面地址，并置可读
     // 写等标志（U/S、R/W、P）。在刷新页变换高速缓冲之后，最后将原页面内容复制
     // 到新页面上。
+	if (old_page < LOW_MEM)
+		check_rss();
 	if (!(new_page=get_free_page()))
 		oom();
-	if (old_page >= LOW_MEM)
+	if (old_page >= LOW_MEM) {
 		mem_map[MAP_NR(old_page)]--;
+		if (current->shared > 0)
+			current->shared--;
+	} else
+		current->rss++;
 	*table_entry = new_page | 7;
-	invalidate();
-	copy_page(old_page,new_page);
+	invalidate_page(address);
+	if (old_page != ZERO_PAGE)	/* new pages are already clear */
+		copy_page(old_page,new_page);
 }	
 
 /*
@@ -407,6 +580,7 @@ void do_wp_page(unsigned long error_code,unsigned long address)
 	if (CODE_SPACE(address))
 		do_exit(SIGSEGV);
 #endif
+	current->min_flt++;
     // 调用上面函数un_wp_page()来处理取消页面保护。但首先需要为其准备好参数。参
     // 数是线性地址address指定页面在页表中的页表项指针，其计算方法是：
     // 1.((address>>10) & 0xffc): 计算指定线性地址中页表项在页表中的偏移地址；因
@@ -427,7 +601,7 @@ void do_wp_page(unsigned long error_code,unsigned long address)
     // 表项的指针(物理地址)。这里对共享的页面进行复制。
 	un_wp_page((unsigned long *)
 		(((address>>10) & 0xffc) + (0xfffff000 &
-		*((unsigned long *) ((address>>20) &0xffc)))));
+		*cur_dir_entry(address))), address);
 
 }
 
@@ -445,14 +619,14 @@ void write_verify(unsigned long address)
     // 一个物理页面。
     // 接着程序从目录项中取页表地址，加上指定页面在页表中的页表项偏移值，得对应
     // 地址的页表项指针。在该表项中包含这给定线性地址对应的物理页面。
-	if (!( (page = *((unsigned long *) ((address>>20) & 0xffc)) )&1))
+	if (!( (page = *cur_dir_entry(address)) &1))
 		return;
 	page &= 0xfffff000;
 	page += ((address>>10) & 0xffc);
     // 然后判断该页表项中的位1(R/W)、位0(P)标志。如果该页面不可写(R/W=0)且存在，
     // 那么就执行共享检验和复制页面操作(写时复制)。否则什么也不做，直接退出。
 	if ((3 & *(unsigned long *) page) == 1)  /* non-writeable, present */
-		un_wp_page((unsigned long *) page);
+		un_wp_page((unsigned long *) page, address);
 	return;
 }
 
@@ -471,6 +645,28 @@ void get_empty_page(unsigned long address)
 	}
 }
 
+/*
+ * Map the zero page read-only at 'address'. The first write to it
+ * ends up in do_wp_page(), which replaces it with a private page.
+ * Returns 0 if we couldn't get a page table.
+ */
+static unsigned long put_zero_page(unsigned long address)
+{
+	unsigned long tmp, *page_table;
+
+	page_table = cur_dir_entry(address);
+	if ((*page_table)&1)
+		page_table = (unsigned long *) (0xfffff000 & *page_table);
+	else {
+		if (!(tmp=get_free_page()))
+			return 0;
+		*page_table = tmp|7;
+		page_table = (unsigned long *) tmp;
+	}
+	page_table[(address>>12) & 0x3ff] = ZERO_PAGE | 5;
+	return ZERO_PAGE;
+}
+
 /*
  * try_to_share() checks the page at address "address" in the task "p",
  * to see if it exists, and if it is clean. If so, share it with the current
@@ -500,9 +696,9 @@ static int try_to_share(unsigned long address, struct task_struct * p)
     // 录项from_page。而'逻辑'页目录项号加上当前进程CPU 4G线性空间中起始地址对应
     // 的页目录项，即可最后得到当前进程中地址address处页面所对应的4G线性空间中的
     // 实际页目录项to_page。
-	from_page = to_page = ((address>>20) & 0xffc);
-	from_page += ((p->start_code>>20) & 0xffc);
-	to_page += ((current->start_code>>20) & 0xffc);
+	from_page = (unsigned long) dir_entry(p->thread.cr3,
+		p->start_code + address);
+	to_page = (unsigned long) cur_dir_entry(current->start_code + address);
     // 在得到p进程和当前进程address对应的目录项后，下面分别对进程p和当前进程进行
     // 处理。下面首先对p进程的表项进行操作。目标是取得p进程中address对应的物理内
     // 存页面地址，并且该物理页面存在，而且干净(没有被修改过)。
@@ -554,12 +750,15 @@ static int try_to_share(unsigned long address, struct task_struct * p)
 /* share them: write-protect */
 	*(unsigned long *) from_page &= ~2;
 	*(unsigned long *) to_page = *(unsigned long *) from_page;
-    // 随后刷新页变换高速缓冲。计算所操作屋里页面的页面号，并将对应页面映射字节数
-    // 组项中的引用递增1。最后返回1，表示共享处理成功。
-	invalidate();
+    // 计算所操作物理页面的页面号，并将对应页面映射字节数组项中的引用递增1。最后
+    // 返回1，表示共享处理成功。
+/* p's page directory isn't loaded, switching to it will flush the TLB */
 	phys_addr -= LOW_MEM;
 	phys_addr >>= 12;
-	mem_map[phys_addr]++;
+	if (mem_map[phys_addr]++ == 1)
+		p->shared++;
+	current->rss++;
+	current->shared++;
 	return 1;
 }
 
@@ -586,7 +785,7 @@ static int try_to_share(unsigned long address, struct task_struct * p)
 // 返回：1 - 共享操作成功，0 - 失败。
 static int share_page(unsigned long address)
 {
-	struct task_struct ** p;
+	struct task_struct * p;
 
     // 首先检查一下当前进程的executable字段是否指向某执行文件的i节点，以判断本
     // 进程是否有对应的执行文件。如果没有，则返回0.如果executable的确指向某个i
@@ -601,16 +800,14 @@ static int share_page(unsigned long address)
     // 执行文件的另一个进程，并尝试对指定地址的页面进行共享。如果找到某个进程p，
     // 其executable字段值与当前进程的相同，则调用try_to_share()尝试页面共享。若
     // 共享操作成功，则函数返回1。否则返回0，表示共享页面操作失败.
-	for (p = &LAST_TASK ; p > &FIRST_TASK ; --p) {
-		if (!*p)
-			continue;
-		if (current == *p)
+	for_each_task(p) {
+		if (current == p)
 			continue;
         // 如果executable不等，表示运行的不是与当前进程相同的执行文件，因此也继续
         // 寻找。
-		if ((*p)->executable != current->executable)
+		if (p->executable != current->executable)
 			continue;
-		if (try_to_share(address,*p))
+		if (try_to_share(address,p))
 			return 1;
 	}
 	return 0;
@@ -643,11 +840,22 @@ void do_no_page(unsigned long error_code,unsigned long address)
     // 码段地址，字段end_data是代码加数据长度。对于Linux0.11内核，它的代码段和
     // 数据段其实基址相同。
 	if (!current->executable || tmp >= current->end_data) {
+		current->min_flt++;
+		if (!(error_code & 2)) {
+			if (!put_zero_page(address))
+				oom();
+			return;
+		}
+		check_rss();
 		get_empty_page(address);
 		return;
 	}
-	if (share_page(tmp))
+	check_rss();
+	if (share_page(tmp)) {
+		current->min_flt++;
 		return;
+	}
+	current->maj_flt++;
 	if (!(page = get_free_page()))
 		oom();
 /* remember that 1 block is used for header */
@@ -718,6 +926,7 @@ void calc_mem(void)
 {
 	int i,j,k,free=0;
 	long * pg_tbl;
+	unsigned long * dir;
 
     // 扫描内存页面映射数组mem_map[]，获取空闲页面数并显示。然后扫描所有的页目
     // 录项(除0，1项)，如果页目录项有效，则统计对应页表中有效页面数，并显示。页
@@ -725,9 +934,10 @@ void calc_mem(void)
 	for(i=0 ; i<PAGING_PAGES ; i++)
 		if (!mem_map[i]) free++;
 	printk("%d pages free (of %d)\n\r",free,PAGING_PAGES);
+	dir = (unsigned long *) current->thread.cr3;
 	for(i=2 ; i<1024 ; i++) {               // 初始值应该等于4
-		if (1&pg_dir[i]) {
-			pg_tbl=(long *) (0xfffff000 & pg_dir[i]);
+		if ((dir[i] & 0x81) == 1) {		/* not for 4Mb pages */
+			pg_tbl=(long *) (0xfffff000 & dir[i]);
 			for(j=k=0 ; j<1024 ; j++)
 				if (pg_tbl[j]&1)
 					k++;